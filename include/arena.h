@@ -0,0 +1,110 @@
+/*
+ * arena.h
+ *
+ * CS280
+ * Spring 2025
+*/
+
+#ifndef ARENA_H_
+#define ARENA_H_
+
+#include <cstddef>
+#include <cstring>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+
+//A run of count objects in an Arena; like a vector that can't grow
+template <class T>
+class Span {
+	T*	items;
+	size_t	count;
+
+public:
+	Span() : items(NULL), count(0) {}
+	Span(T* items, size_t count) : items(items), count(count) {}
+
+	size_t	size() const { return count; }
+	bool	empty() const { return count == 0; }
+	T&	operator[](size_t i) const { return items[i]; }
+	T&	back() const { return items[count - 1]; }
+	T*	begin() const { return items; }
+	T*	end() const { return items + count; }
+};
+
+//Memory handed out by bumping a pointer through 64 KB blocks, all given back
+//at once when the arena is cleared or destroyed. Nothing in an arena is ever
+//destroyed, so only trivially destructible objects may live there.
+class Arena {
+	vector<unique_ptr<char[]>>	blocks;
+	char*	next;		//free space in the current block
+	size_t	left;
+	size_t	used;		//bytes handed out
+	size_t	reserved;	//bytes in all blocks
+	size_t	wasted;		//alignment padding and tails of blocks given up on
+
+	void* AllocSlow(size_t size, size_t align);
+
+public:
+	static constexpr size_t BLOCK = 64 * 1024;
+
+	struct Stats {
+		size_t	used;
+		size_t	blocks;
+		size_t	reserved;
+		size_t	wasted;
+
+		//share of the space given up on that is lost to padding and block tails
+		double	Fragmentation() const { return used + wasted == 0 ? 0 : (double) wasted / (used + wasted); }
+	};
+
+	Arena() : next(NULL), left(0), used(0), reserved(0), wasted(0) {}
+	Arena(const Arena&) = delete;
+	Arena& operator=(const Arena&) = delete;
+
+	void* Alloc(size_t size, size_t align) {
+		size_t pad = -(uintptr_t) next & (align - 1);
+		if( pad + size > left )
+			return AllocSlow(size, align);
+		char* p = next + pad;
+		next = p + size;
+		left -= pad + size;
+		used += size;
+		wasted += pad;
+		return p;
+	}
+
+	template <class T, class... Args>
+	T* New(Args&&... args) {
+		static_assert(is_trivially_destructible<T>::value, "arena objects are never destroyed");
+		return new (Alloc(sizeof(T), alignof(T))) T(forward<Args>(args)...);
+	}
+
+	template <class T>
+	Span<T> Copy(const vector<T>& v) {
+		static_assert(is_trivially_copyable<T>::value, "arena spans are copied bytewise");
+		if( v.empty() )
+			return Span<T>();
+		T* items = (T*) Alloc(v.size() * sizeof(T), alignof(T));
+		memcpy(items, v.data(), v.size() * sizeof(T));
+		return Span<T>(items, v.size());
+	}
+
+	//a NUL-terminated copy of s
+	const char* Text(string_view s);
+
+	//give back every block at once
+	void Clear();
+
+	Stats GetStats() const { return Stats{ used, blocks.size(), reserved, wasted }; }
+};
+
+
+#endif /* ARENA_H_ */
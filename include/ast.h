@@ -0,0 +1,168 @@
+/*
+ * ast.h
+ * Syntax tree of a SADAL program: built once by the parser, then run by the
+ * evaluator as many times as needed
+ * CS280 - Spring 2025
+ */
+
+#ifndef AST_H_
+#define AST_H_
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "lex.h"
+#include "val.h"
+#include "arena.h"
+
+using namespace std;
+
+
+//Expression rules of the grammar, outermost first. A node belongs to the level
+//of the rule that built it; a rule that only passes its one operand up builds
+//nothing, but still reports its part of a failure below it (see exec.cpp).
+enum ExprLevel { L_EXPR, L_RELATION, L_SIMPLE, L_STERM, L_TERM, L_FACTOR, L_PRIMARY };
+
+enum ExprKind {
+	E_CONST,	//literal; a numeric one carries the sign of a leading unary minus
+	E_VAR,		//variable
+	E_INDEX,	//variable(lo) or variable(lo..hi)
+	E_PAREN,	//( Expr )
+	E_SIGN,		//unary minus over a term: only checks the operand is numeric
+	E_NOT,		//NOT Primary
+	E_BINARY	//AND, OR, relational, + - &, * / MOD, **
+};
+
+struct ExprNode {
+	ExprKind	kind;
+	Token	op;		//E_BINARY operator
+	int	line;		//line a run-time error of this node is reported at
+	int	line2;		//AND, OR: line of the operator; E_INDEX: line after lo
+	int	slot;		//E_VAR frame slot of the variable
+	ValType	vtype;		//E_CONST type and value
+	union {
+		int	ival;
+		double	rval;
+		bool	bval;
+		char	cval;
+		size_t	slen;
+	};
+	const char*	text;	//E_CONST string, in the program's arena
+	ExprNode*	left;	//operand; E_INDEX: the E_VAR indexed
+	ExprNode*	right;	//right operand; E_INDEX: lo
+	ExprNode*	hi;	//E_INDEX: hi, NULL for a single index
+
+	ExprNode(ExprKind kind, int line)
+		: kind(kind), op(ERR), line(line), line2(line), slot(-1), vtype(VERR), rval(0),
+		  text(NULL), left(NULL), right(NULL), hi(NULL) {}
+
+	//E_CONST value
+	Value	Const() const;
+};
+
+//level of the rule that built e
+ExprLevel Level(const ExprNode* e);
+//what the rule of a level says when the one operand it passed up fails, or NULL
+const char* PassMessage(ExprLevel level);
+
+
+//A syntax error is not reported when it is found but when execution reaches it,
+//which is where the one-pass interpreter used to run into it
+struct SyntaxMsg {
+	int	line;
+	const char*	msg;
+};
+
+enum StmtKind { S_PRINT, S_GET, S_ASSIGN, S_IF, S_ERROR };
+
+struct StmtNode;
+
+//IF or ELSIF condition and its statements, or the ELSE statements (no cond)
+struct IfClause {
+	ExprNode*	cond;
+	int	line;			//line the condition type is checked at
+	Span<SyntaxMsg>	errors;	//condition that did not parse
+	Span<StmtNode*>	body;	//may end in an S_ERROR
+
+	IfClause() : cond(NULL), line(0) {}
+};
+
+struct StmtNode {
+	StmtKind	kind;
+	int	line;		//line a run-time error of the statement is reported at
+	bool	newline;	//S_PRINT: putline
+	int	slot;		//S_GET, S_ASSIGN target's frame slot, -1 if it was never declared
+	Token	type;		//its declared type, ERR if it was never declared
+	ExprNode*	expr;	//S_PRINT, S_ASSIGN
+	Span<IfClause>	clauses;	//S_IF
+	Span<SyntaxMsg>	errors;		//S_ERROR: a statement that did not parse
+
+	StmtNode(StmtKind kind, int line)
+		: kind(kind), line(line), newline(false), slot(-1), type(ERR), expr(NULL) {}
+};
+
+struct DeclNode {
+	Span<int>	slots;	//frame slots of the variables declared
+	Token	type;
+	ExprNode*	init;	//NULL without an initializer
+	int	initLine;	//line the initializer type is checked at
+	int	line;		//line at the closing semicolon
+	int	redefined;	//frame slot of the first one declared before, or -1
+	Span<SyntaxMsg>	errors;	//a declaration that did not parse
+
+	DeclNode() : type(ERR), init(NULL), initLine(0), line(0), redefined(-1) {}
+};
+
+//A parsed procedure. Its nodes, lists and texts are all allocated from its
+//arena and go in one piece with it; running it does not change it, so it can
+//be run again.
+//Each variable is given the next frame slot as it is declared, and the nodes
+//refer to it by slot: its value when running is frame[slot] of an array of
+//Frame() values, whatever else the lexer has interned.
+class Program {
+	Arena	arena;
+	vector<int>	slots;		//frame slot by symbol id, -1 if not declared
+
+public:
+	int	procName;
+	vector<string_view>	names;	//variable name by frame slot, in the arena
+	vector<Token>	types;		//declared type by frame slot
+	Span<DeclNode*>	decls;		//the last one may not have parsed
+	Span<StmtNode*>	body;		//may end in an S_ERROR
+	Span<SyntaxMsg>	headErrors;	//procedure heading did not parse
+	Span<SyntaxMsg>	bodyErrors;	//BEGIN, END or the closing name did not parse
+
+	Program() : procName(-1) {}
+	Program(const Program&) = delete;
+	Program& operator=(const Program&) = delete;
+
+	ExprNode* NewExpr(ExprKind kind, int line) { return arena.New<ExprNode>(kind, line); }
+	StmtNode* NewStmt(StmtKind kind, int line) { return arena.New<StmtNode>(kind, line); }
+	DeclNode* NewDecl() { return arena.New<DeclNode>(); }
+	template <class T>
+	Span<T> Copy(const vector<T>& v) { return arena.Copy(v); }
+	const char* Text(string_view s) { return arena.Text(s); }
+
+	Arena::Stats	MemoryStats() const { return arena.GetStats(); }
+
+	int Frame() const { return names.size(); }
+	int SlotOf(int sym) const { return sym < (int) slots.size() ? slots[sym] : -1; }
+	Token TypeOf(int sym) const { int slot = SlotOf(sym); return slot < 0 ? ERR : types[slot]; }
+	//frame slot of a new variable sym, called name
+	int Declare(int sym, string_view name, Token type) {
+		if( sym >= (int) slots.size() )
+			slots.resize(sym + 1, -1);
+		slots[sym] = names.size();
+		names.push_back(string_view(Text(name), name.size()));
+		types.push_back(type);
+		return slots[sym];
+	}
+};
+
+//replace the constant parts of prog's expressions by their values, where
+//working them out can't fail (see fold.cpp)
+void Fold(Program& prog);
+
+
+#endif /* AST_H_ */
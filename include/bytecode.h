@@ -0,0 +1,158 @@
+/*
+ * bytecode.h
+ * Register bytecode for a SADAL procedure: the syntax tree lowered once into
+ * a flat list of three-address instructions, run by a dispatch loop instead
+ * of a tree walk
+ * CS280 - Spring 2025
+ */
+
+#ifndef BYTECODE_H_
+#define BYTECODE_H_
+
+#include <cstdint>
+#include <map>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "ast.h"
+#include "runtime.h"
+
+using namespace std;
+
+
+//Every value an instruction reads or writes is in a register. A variable's
+//register is its frame slot; expression temporaries follow the variables and
+//the constants follow the temporaries, loaded before the program runs.
+//a, b, c are registers unless said otherwise.
+enum OpCode {
+	OP_MOVE,	//a = b
+	OP_CHECK,	//variable a must have been assigned
+	OP_ISINT,	//a must be an integer: the start index of a range
+	OP_INDEX,	//a = b(c)
+	OP_SLICE,	//a = a(b..c)
+	OP_SIGN,	//a must be numeric
+	OP_NOT,		//a = NOT b
+	OP_ADD, OP_SUB, OP_CONCAT,	//a = b op c
+	OP_MUL, OP_DIV, OP_MOD,
+	OP_EXP,
+	OP_EQ, OP_NEQ, OP_LTHAN, OP_LTE, OP_GTHAN, OP_GTE,
+	OP_AND,		//b must be boolean; a = b, and if false jump to c
+	OP_OR,		//b must be boolean; a = b, and if true jump to c
+	OP_TESTBOOL,	//a must be boolean: the right operand of AND, OR
+	OP_PRINT,	//print a; b: putline
+	OP_GET,		//read variable a of type site.type
+	OP_ASSIGN,	//variable a = b if of type site.type; c: b is a temporary, move it
+	OP_INIT,	//a must be of type site.type: a declaration's initializer
+	OP_REDEFINED,	//report variable site.sym declared again
+	OP_COND,	//a must be boolean; false: jump to c
+	OP_JUMP,	//to c
+	OP_FAIL,	//report the syntax errors failures[a] execution has reached
+	OP_HALT,
+
+	//The compiler knows the operands are of the type in the name, from the
+	//declarations, and these make no checks of type at all
+	OP_TAKE,	//a = b, which is a temporary: an assignment of the declared type
+	OP_ADDI, OP_SUBI, OP_MULI, OP_DIVI, OP_MODI,	//a = b op c
+	OP_ADDR, OP_SUBR, OP_MULR, OP_DIVR,
+	OP_EQI, OP_NEQI, OP_LTHANI, OP_LTEI, OP_GTHANI, OP_GTEI,
+	OP_EQR, OP_NEQR, OP_LTHANR, OP_LTER, OP_GTHANR, OP_GTER,
+	OP_EQS, OP_NEQS, OP_CONCATS,
+	OP_NOTB,	//a = NOT b
+	OP_ANDB,	//a = b, and if false jump to c
+	OP_ORB,		//a = b, and if true jump to c
+	OP_CONDB,	//false a: jump to c
+	OP_COUNT
+};
+
+struct Instr {
+	OpCode	op;
+	int	a, b, c;
+	int	site;		//sites index, -1 for an instruction that can't fail
+};
+
+//Where an instruction that can fail came from. Once it has reported its own
+//error at line, every rule the failing phrase was nested in adds its own
+//message on the way out, as the tree evaluator's functions do on returning
+//false; those messages are known at compile time and are its chain.
+struct Site {
+	int	line;
+	int	sym;		//OP_REDEFINED: variable; OP_COND: clause, 0 for the IF condition
+	Token	type;
+	int	chain;		//chains index of the first message, -1 for none
+};
+
+//One message of a chain and the chain that follows it. Chains share their
+//tails, as the phrases they come from share the rules around them.
+struct ChainLink {
+	const char*	msg;
+	int	next;
+};
+
+//A compiled procedure. Its messages of syntax errors and names of variables
+//point into the Program it was compiled from, which must outlive it.
+class Code {
+public:
+	vector<Instr>	code;
+	vector<ValType>	types;	//declared type of each variable
+	vector<string_view>	names;	//name of each variable
+	int	vars;		//registers of variables, then of temporaries
+	int	temps;
+	int	live;		//temporaries in use while compiling
+	vector<Value>	consts;	//initial values of the last registers
+	vector<Site>	sites;
+	vector<Span<SyntaxMsg>>	failures;
+	vector<ChainLink>	chains;	//each distinct link stored once
+
+	Code() : vars(0), temps(0), live(0) {}
+
+	int Registers() const { return vars + temps + consts.size(); }
+	int ConstBase() const { return vars + temps; }
+
+	int AddSite(const Site& site) { sites.push_back(site); return sites.size() - 1; }
+	//register of a new temporary
+	int Temp() {
+		if( ++live > temps )
+			temps = live;
+		return vars + live - 1;
+	}
+	//consts index of the value of E_CONST e, each value stored once
+	int AddConst(const ExprNode* e);
+	//chain of msg followed by chain next
+	int Chain(const char* msg, int next);
+	int Emit(OpCode op, int a = 0, int b = 0, int c = 0, int site = -1) {
+		code.push_back(Instr{ op, a, b, c, site });
+		return code.size() - 1;
+	}
+	int Here() const { return code.size(); }
+	void Patch(int at) { code[at].c = Here(); }
+
+private:
+	map<pair<ValType, uint64_t>, int>	constIndex;
+	unordered_map<string_view, int>	stringIndex;
+	struct LinkHash {
+		size_t operator()(const pair<const char*, int>& k) const {
+			return hash<const char*>()(k.first) * 31 + k.second;
+		}
+	};
+	unordered_map<pair<const char*, int>, int, LinkHash>	chainIndex;
+	ChainLink	recent[64] = {};	//links last looked up, by hash, in front of chainIndex
+	int	recentAt[64];
+};
+
+//lower prog into code
+void Compile(const Program& prog, Code& code);
+//run compiled code the way Execute runs the tree it came from
+bool Run(const Code& code, Runtime& rt);
+//the same, on the standard streams
+bool Run(const Code& code);
+//run the instruction at alone, on the registers regs, for code running the
+//others itself: 0 if the program failed there, 1 if it halted, otherwise
+//2 + the index of the instruction to run next
+int Step(const Code& code, Runtime& rt, Value* regs, int at);
+//how Run dispatches: "computed goto", or "switch" where that is not available
+//or VM_SWITCH is defined
+const char* DispatchKind();
+
+
+#endif /* BYTECODE_H_ */
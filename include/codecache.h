@@ -0,0 +1,54 @@
+/*
+ * codecache.h
+ * Compiled SADAL programs kept in cache files, so a program run again is
+ * neither lexed, parsed nor compiled
+ * CS280 - Spring 2025
+ */
+
+#ifndef CODECACHE_H_
+#define CODECACHE_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "bytecode.h"
+#include "srcfile.h"
+
+using namespace std;
+
+
+//A cache file holds the Code of one source, with every text it points to,
+//behind a header naming the source by its size and hash. The file is only
+//good for the same source, and for the build of the instruction set that
+//wrote it.
+
+//hash of a program's source, which its cache file is kept under
+uint64_t SourceHash(const char* data, size_t len);
+
+//write code, compiled from the source of that hash and size, to the file
+//path; written under another name and then renamed, so a run reading path
+//never sees half of it. False if it could not be written.
+bool SaveCode(const Code& code, uint64_t hash, size_t size, const string& path);
+
+//Code read back from a cache file with one mmap. Its texts point into the
+//file, which stays mapped for as long as this does.
+class CachedCode {
+	SourceFile	file;
+	vector<SyntaxMsg>	msgs;
+
+	CachedCode(const CachedCode&) = delete;
+	CachedCode& operator=(const CachedCode&) = delete;
+
+public:
+	Code	code;
+
+	CachedCode() {}
+
+	//false if there is no file at path, or it is for some other source or
+	//build, or it is damaged; then it has to be compiled again
+	bool Load(const string& path, uint64_t hash, size_t size);
+};
+
+
+#endif /* CODECACHE_H_ */
@@ -0,0 +1,27 @@
+/*
+ * emitcpp.h
+ * Translation of a compiled SADAL procedure into a C++ program of its own
+ * CS280 - Spring 2025
+ */
+
+#ifndef EMITCPP_H_
+#define EMITCPP_H_
+
+#include <iostream>
+#include <string>
+
+#include "bytecode.h"
+
+using namespace std;
+
+
+//write code as the source of a C++ program that runs it as Run does, on the
+//standard streams, and then reports how it went as the driver does. The
+//program needs nothing but the standard library: variables of a declared
+//type are locals of that type, and the little run-time support it uses is
+//written out with it. name is the source code was compiled from, for the
+//reader.
+void EmitCpp(const Code& code, const string& name, ostream& out);
+
+
+#endif /* EMITCPP_H_ */
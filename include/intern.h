@@ -0,0 +1,43 @@
+/*
+ * intern.h
+ *
+ * CS280
+ * Spring 2025
+*/
+
+#ifndef INTERN_H_
+#define INTERN_H_
+
+#include <string>
+#include <deque>
+#include <vector>
+#include <cstddef>
+
+using namespace std;
+
+
+//Maps each distinct identifier to a dense integer id (0, 1, 2, ...).
+//SADAL names are case-insensitive: lookups ignore case and names are kept in lower case.
+class Interner {
+	deque<string>	names;		//id -> name; a deque so Name() references stay valid
+	vector<int>	slots;		//open-addressing hash table of ids, -1 when empty
+	vector<unsigned>	hashes;	//id -> hash of its name
+
+	void Grow();
+
+public:
+	Interner() : slots(64, -1) {}
+
+	//id of the name s[0..len), adding it if it is new
+	int Intern(const char* s, size_t len);
+	int Intern(const string& s) { return Intern(s.data(), s.length()); }
+
+	const string& Name(int id) const { return names[id]; }
+	int Size() const { return (int) names.size(); }
+
+	//forget every name, keeping the table's room; the ids start again from 0
+	void Clear();
+};
+
+
+#endif /* INTERN_H_ */
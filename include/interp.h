@@ -0,0 +1,51 @@
+/*
+ * interp.h
+ * A SADAL interpreter as an object: it parses a program from a buffer and
+ * runs it on the streams it is given
+ * CS280 - Spring 2025
+ */
+
+#ifndef INTERP_H_
+#define INTERP_H_
+
+#include <iostream>
+#include <string>
+
+#include "intern.h"
+
+using namespace std;
+
+
+//Everything a run changes is the interpreter's own or lives only for the
+//run, so interpreters on separate threads can run programs at the same time.
+//One interpreter runs one program at a time, and may then run another.
+class Interpreter {
+public:
+	//walk the syntax tree, or compile it to bytecode, and that on to
+	//machine code where there is a JIT
+	enum Engine { TREE, VM, JIT };
+
+	Interpreter(Engine engine = TREE) : engine(engine), errors(0) {}
+
+	Interpreter(const Interpreter&) = delete;
+	Interpreter& operator=(const Interpreter&) = delete;
+
+	//parse the program text[0..len) and run it: its input is read from in, its
+	//output and errors are written to out, and what the Value operators
+	//complain of to err. True if it ran to the end, errors or not, as Prog.
+	bool Run(const char* text, size_t len, istream& in, ostream& out, ostream& err);
+	bool Run(const string& text, istream& in, ostream& out, ostream& err) {
+		return Run(text.data(), text.size(), in, out, err);
+	}
+
+	//errors of the last run
+	int ErrCount() const { return errors; }
+
+private:
+	Engine	engine;
+	Interner	names;		//identifiers of the program being run
+	int	errors;
+};
+
+
+#endif /* INTERP_H_ */
@@ -0,0 +1,51 @@
+/*
+ * jit.h
+ * Machine code for the register bytecode of a SADAL procedure
+ * CS280 - Spring 2025
+ */
+
+#ifndef JIT_H_
+#define JIT_H_
+
+#include "bytecode.h"
+
+using namespace std;
+
+
+//Code compiled once more, into x86-64 machine code in executable memory, on
+//Linux. An instruction the compiler typed as working on ints, reals or bools
+//becomes a few machine instructions on the registers in place, and so do
+//jumps and the check that a variable has been assigned. Every other
+//instruction, and one of those when it fails, has the VM run it alone
+//(Step), so strings, input and output, and every error message are the VM's
+//own. Elsewhere nothing is compiled, and the VM runs the code instead.
+class NativeCode {
+public:
+	NativeCode() : code(NULL), mem(NULL), size(0), entry(NULL) {}
+	~NativeCode();
+
+	NativeCode(const NativeCode&) = delete;
+	NativeCode& operator=(const NativeCode&) = delete;
+
+	//compile code, which must outlive this; false where there is no JIT,
+	//or no executable memory to be had
+	bool Compile(const Code& code);
+	//run it as Run runs the code it was compiled from
+	bool Run(Runtime& rt) const;
+
+private:
+	const Code*	code;
+	void*	mem;
+	size_t	size;
+	int	(*entry)(Value* regs, void* frame);
+};
+
+//run code as machine code, or on the VM where it can't be compiled
+bool RunNative(const Code& code, Runtime& rt);
+//the same, on the standard streams
+bool RunNative(const Code& code);
+//what machine code this build compiles to: "x86-64", or "none"
+const char* JitKind();
+
+
+#endif /* JIT_H_ */
@@ -11,8 +11,15 @@
 #include <string>
 #include <iostream>
 #include <map>
+#include <cstddef>
+#include <vector>
+#include <memory>
+#include <string_view>
+#include <type_traits>
 using namespace std;
 
+#include "intern.h"
+
 
 //Definition of all the possible token types in the SADAL Language
 enum Token {
@@ -37,36 +44,199 @@ enum Token {
 };
 
 
+//Text a token refers to that has no home in the source: error messages, and
+//everything read through an istream. It is kept in blocks that go with the
+//pool, which belongs to whatever keeps the tokens (a TokenBuffer, a
+//LexStream), so it is released with them. A pool is filled by one thread.
+class LexemePool {
+	vector<unique_ptr<char[]>>	blocks;
+	char*	next;
+	size_t	left;
+
+public:
+	static const size_t BLOCK = 64 * 1024;
+
+	LexemePool() : next(NULL), left(0) {}
+	LexemePool(LexemePool&&) = default;
+	LexemePool& operator=(LexemePool&&) = default;
+
+	//a copy of s[0..len) that lasts as long as the pool
+	const char*	Copy(const char* s, size_t len);
+	//take over the text of other, which is left empty
+	void	Adopt(LexemePool& other);
+};
+
+
 //Class definition of LexItem
+//A LexItem is 16 bytes and trivially copyable, so tokens are returned, copied and
+//pushed back without allocating. Next to the kind and line it holds one of: the
+//interned name of an IDENT (its id in place of the length, so ids stay below
+//MAXLEN) or a pointer to the text of any other token, numeric constants
+//included, so that they are printed as written. That text lives in the source buffer,
+//in a static spelling table (keywords, operators) or in a LexemePool, and
+//stays valid for as long as both do; a name, for as long as the Interner it
+//is in.
 class LexItem {
-	Token	token;
-	string	lexeme;
+	unsigned	token : 8;
+	unsigned	len : 24;
 	int	lnum;
+	union {
+		const char*	text;
+		const string*	name;
+	};
+
+	friend class TokenBuffer;
 
 public:
-	LexItem() {
-		token = ERR;
-		lnum = -1;
-	}
-	LexItem(Token token, string lexeme, int line) {
-		this->token = token;
-		this->lexeme = lexeme;
-		this->lnum = line;
-	}
+	//longest text a token can refer to
+	static constexpr size_t MAXLEN = (1u << 24) - 1;
+
+	LexItem() : token(ERR), len(0), lnum(-1), text("") {}
+	//text[0..len) must outlive the token
+	LexItem(Token token, const char* text, size_t len, int line)
+		: token(token), len(len < MAXLEN ? len : MAXLEN), lnum(line), text(text) {}
+	//lexeme is copied to pool unless it is the token's own spelling
+	LexItem(Token token, const string& lexeme, int line, LexemePool& pool);
+	//sym must be at most MAXLEN; IdentItem checks
+	LexItem(int sym, const string& name, int line) : token(IDENT), len(sym), lnum(line), name(&name) {}
 
-	bool operator==(const Token token) const { return this->token == token; }
-	bool operator!=(const Token token) const { return this->token != token; }
+	bool operator==(const Token token) const { return this->token == (unsigned) token; }
+	bool operator!=(const Token token) const { return this->token != (unsigned) token; }
 
-	Token	GetToken() const { return token; }
-	string	GetLexeme() const { return lexeme; }
+	Token	GetToken() const { return (Token) token; }
+	//the token's text
+	string_view	Text() const {
+		if( token == IDENT )
+			return *name;
+		return string_view(text, len);
+	}
+	//a copy of the text
+	string	GetLexeme() const { return string(Text()); }
 	int	GetLinenum() const { return lnum; }
+	int	GetSymbol() const { return token == IDENT ? (int) len : -1; }
+	//value of an ICONST or FCONST, which the lexer has checked fits: an
+	//integer is its digits up to any exponent, as stoi read it. It is
+	//converted from the text again on each call: a LexItem has room for
+	//the text or the value, not both, and the parser asks once per constant.
+	int	GetIntValue() const;
+	double	GetRealValue() const;
+	//an ERR token for a numeric constant too big for its type, or for a
+	//name past the most an IDENT token can number
+	bool	OutOfRange() const;
 };
 
+static_assert(sizeof(LexItem) == 16 && is_trivially_copyable<LexItem>::value,
+	"LexItem must stay a 16-byte value type");
+
 
+//Contiguous source text (a mapped file or an in-memory copy) scanned in place
+struct LexBuffer {
+	const char*	cur;	//next character to scan
+	const char*	end;	//one past the last character
+	Interner*	names;	//where IDENT lexemes are interned
+	LexemePool*	pool;	//where error messages go; a TokenBuffer or
+				//LexStream scans with its own
+
+	LexBuffer(const char* data, size_t len, Interner* names, LexemePool* pool = NULL)
+		: cur(data), end(data + len), names(names), pool(pool) {}
+};
 
 extern ostream& operator<<(ostream& out, const LexItem& tok);
+//IDENT token for name id sym of names, or an ERR token when sym is too big
+//for a token to hold
+extern LexItem IdentItem(int sym, const Interner& names, int linenum);
+extern LexItem id_or_kw(const string& lexeme, int linenum, Interner& names, LexemePool& pool);
+extern LexItem getNextToken(istream& in, int& linenum, Interner& names, LexemePool& pool);
+//the same, with names and text that last as long as the calling thread
 extern LexItem id_or_kw(const string& lexeme, int linenum);
 extern LexItem getNextToken(istream& in, int& linenum);
+//buf.pool must be set
+extern LexItem getNextToken(LexBuffer& buf, int& linenum);
+//advance buf.cur over white space and comments to the next token (or buf.end)
+extern void SkipBlanks(LexBuffer& buf, int& linenum);
+
+//Source read from a stream (a pipe, stdin, ...) in large blocks into a reusable
+//buffer and lexed there by getNextToken(LexBuffer&), so there is no per-character
+//stream call. Only whole lines are handed to the scanner, and no token runs past
+//the end of its line, so a token is never cut at a block boundary. The buffer
+//holds at most a block plus the longest line, however long the program is.
+//Text of string and character constants is copied out of the buffer into a small
+//ring of slots, and stays valid until TEXTSLOTS more such tokens have been read.
+class LexStream {
+	istream&	in;
+	size_t	block;		//bytes read at a time
+	vector<char>	data;
+	const char*	cur;		//next character to scan
+	const char*	lineEnd;	//just past the last complete line read
+	const char*	fill;		//end of the data read
+	bool	eof;
+	Interner*	names;
+	vector<string>	texts;
+	size_t	nextText;
+	LexemePool	pool;		//error messages
+
+	void Refill();
+
+	LexStream(const LexStream&);
+	LexStream& operator=(const LexStream&);
+
+public:
+	static const size_t BLOCK = 64 * 1024;
+	static const size_t TEXTSLOTS = 16;
+
+	LexStream(istream& in, Interner* names, size_t block = BLOCK);
+
+	//same tokens and line numbers as getNextToken over the whole text at once
+	LexItem Next(int& linenum);
+};
+
+//Whole program lexed up front into one array of LexItems, so the parser can
+//walk it by index, look ahead any distance and rewind for free.
+class TokenBuffer {
+	vector<LexItem>	items;
+	LexemePool	pool;	//text of the tokens not in the source
+
+	void Add(const LexItem& tok);
+	void Append(TokenBuffer& part, int lineBase, const Interner& partNames, Interner& names);
+	struct Chunk;
+	static void LexChunk(Chunk& c, const char* from, const char* limit, const char* end);
+
+public:
+	//lex until DONE; the DONE token is the last one stored
+	void Lex(istream& in, int& linenum, Interner& names);
+	void Lex(LexBuffer& buf, int& linenum);
+	//same tokens as Lex(buf, linenum), lexed by up to threads threads working on
+	//separate stretches of the buffer (0: one per core, if the source is big enough)
+	void LexParallel(LexBuffer& buf, int& linenum, unsigned threads = 0);
+
+	size_t	Size() const { return items.size(); }
+	Token	Kind(size_t i) const { return items[i].GetToken(); }
+	int	Line(size_t i) const { return items[i].GetLinenum(); }
+	int	Symbol(size_t i) const { return items[i].GetSymbol(); }
+	const LexItem&	Item(size_t i) const { return items[i]; }
+};
+
+//Token source handed to the parser: a LexStream, or a TokenBuffer that was
+//lexed in advance and is walked by index
+class LexSource {
+	LexStream*	strm;
+	const TokenBuffer*	toks;
+	size_t	pos;
+
+public:
+	LexSource(LexStream& strm) : strm(&strm), toks(NULL), pos(0) {}
+	LexSource(const TokenBuffer& tb) : strm(NULL), toks(&tb), pos(0) {}
+
+	LexItem Next(int& linenum) {
+		if( toks != NULL ) {
+			//past the end keep returning the final DONE token
+			size_t i = pos < toks->Size() ? pos++ : toks->Size() - 1;
+			linenum = toks->Line(i);
+			return toks->Item(i);
+		}
+		return strm->Next(linenum);
+	}
+};
 
 
 #endif /* LEX_H_ */
@@ -0,0 +1,36 @@
+/*
+ * lexscan.h
+ *
+ * CS280
+ * Spring 2025
+*/
+
+#ifndef LEXSCAN_H_
+#define LEXSCAN_H_
+
+#include <string>
+
+using namespace std;
+
+
+//Block scanning helpers for getNextToken(LexBuffer&). On x86-64 with GCC or
+//Clang they work 32 (AVX2) or 16 (SSE2) bytes at a time, picked at startup
+//from what the CPU supports; elsewhere a scalar version is used.
+
+//first non white space character in [p, end); counts the newlines skipped
+extern const char* SkipSpace(const char* p, const char* end, int& linenum);
+
+//first '\n' in [p, end), or end
+extern const char* FindNewline(const char* p, const char* end);
+
+//first '"' or '\n' in [p, end), or end: the end of a string constant's text
+extern const char* FindStringEnd(const char* p, const char* end);
+
+//name of the routines in use: "avx2", "sse2" or "scalar"
+extern const char* ScanLevel();
+
+//force a given level (for benchmarks and cross-checks); false if unsupported here
+extern bool SetScanLevel(const string& level);
+
+
+#endif /* LEXSCAN_H_ */
@@ -13,8 +13,44 @@ using namespace std;
 
 #include "lex.h"
 #include "val.h"
+#include "ast.h"
 
+struct Runtime;
+
+//parse and run
 extern bool Prog(istream& in, int& line);
+extern bool Prog(LexSource& in, int& line);
+
+//parse only: syntax errors are kept in the tree; true if there were none
+extern bool Parse(LexSource& in, int& line, Program& prog);
+//run a parsed program, printing its output and errors; may be called again
+extern bool Execute(const Program& prog, Runtime& rt);
+//the same, on the standard streams
+extern bool Execute(const Program& prog);
+
+extern bool ProcBody(LexSource& in, int& line);
+extern bool DeclPart(LexSource& in, int& line);
+extern bool DeclStmt(LexSource& in, int& line, vector<DeclNode*>& decls);
+extern bool Type(LexSource& in, int& line);
+extern bool StmtList(LexSource& in, int& line, vector<StmtNode*>& list);
+extern bool Stmt(LexSource& in, int& line, vector<StmtNode*>& list);
+extern bool PrintStmts(LexSource& in, int& line, StmtNode*& stmt);
+extern bool GetStmt(LexSource& in, int& line, StmtNode*& stmt);
+extern bool IfStmt(LexSource& in, int& line, StmtNode*& stmt);
+extern bool AssignStmt(LexSource& in, int& line, StmtNode*& stmt);
+extern bool Var(LexSource& in, int& line, LexItem & idtok);
+extern bool Expr(LexSource& in, int& line, ExprNode*& node);
+extern bool Relation(LexSource& in, int& line, ExprNode*& node);
+extern bool SimpleExpr(LexSource& in, int& line, ExprNode*& node);
+extern bool STerm(LexSource& in, int& line, ExprNode*& node);
+extern bool Term(LexSource& in, int& line, int sign, ExprNode*& node);
+extern bool Factor(LexSource& in, int& line, int sign, ExprNode*& node);
+extern bool Primary(LexSource& in, int& line, int sign, ExprNode*& node);
+extern bool Name(LexSource& in, int& line, int sign, ExprNode*& node);
+extern bool Range(LexSource& in, int& line, ExprNode* node);
+
+//the grammar read straight from a stream, evaluating as it goes, as the
+//stand-alone parsers (parserInterp2.cpp, GivenparserInterpPart.cpp) define it
 extern bool ProcBody(istream& in, int& line);
 extern bool DeclPart(istream& in, int& line);
 extern bool DeclStmt(istream& in, int& line);
@@ -37,6 +73,7 @@ extern bool Primary(istream& in, int& line, int sign, Value & retVal);
 extern bool Name(istream& in, int& line, int sign, Value & retVal);
 extern bool Range(istream& in, int& line, Value & retVal1, Value & retVal2);
 
+//errors of the last run that ended on this thread
 extern int ErrCount();
 
 #endif /* PARSE_H_ */
@@ -0,0 +1,52 @@
+/*
+ * runtime.h
+ * Run-time support shared by the tree evaluator and the bytecode VM
+ * CS280 - Spring 2025
+ */
+
+#ifndef RUNTIME_H_
+#define RUNTIME_H_
+
+#include <iostream>
+#include <string>
+
+#include "lex.h"
+#include "val.h"
+
+using namespace std;
+
+
+//One run of a program: where it reads its input and writes its output, and
+//the errors it has had. A run keeps nothing anywhere else, so runs with a
+//Runtime each can go on at once on separate threads.
+//While it exists the Value operators used on its thread report to err, and
+//when it goes ErrCount() on its thread reports its errors.
+struct Runtime {
+	istream&	in;
+	ostream&	out;
+	int	errors;		//reported so far
+	int	errLine;	//line of the last one, where the rules it was nested in report theirs
+
+	Runtime(istream& in, ostream& out, ostream& err);
+	~Runtime();
+
+	Runtime(const Runtime&) = delete;
+	Runtime& operator=(const Runtime&) = delete;
+
+private:
+	ostream*	valueErrors;	//where the Value operators reported before
+};
+
+//report an error of the running program
+void RunError(Runtime& rt, int line, const string& msg);
+
+//whether val can be stored in a variable declared type
+bool OfType(Token type, const Value& val);
+//read a value for a variable declared type from the run's input
+bool ReadInput(Runtime& rt, Token type, int line, Value& inputVal);
+//replace the string str by str(start), or str(start..end) when end is given,
+//if the indices are in its bounds
+bool Substring(Runtime& rt, Value& str, int start, const Value* end, int line);
+
+
+#endif /* RUNTIME_H_ */
@@ -0,0 +1,41 @@
+/*
+ * srcfile.h
+ *
+ * CS280
+ * Spring 2025
+*/
+
+#ifndef SRCFILE_H_
+#define SRCFILE_H_
+
+#include <string>
+#include <cstddef>
+
+using namespace std;
+
+
+//Read-only view of a whole source file. Regular files are memory-mapped so the
+//lexer can scan them in place; on platforms without mmap the file is read into memory.
+class SourceFile {
+	const char*	data;
+	size_t	size;
+	bool	mapped;
+	string	copy;
+
+	SourceFile(const SourceFile&);
+	SourceFile& operator=(const SourceFile&);
+
+public:
+	SourceFile() : data(""), size(0), mapped(false) {}
+	~SourceFile() { Close(); }
+
+	//false if the file can't be opened or isn't a regular file (pipe, terminal, ...)
+	bool Open(const string& name);
+	void Close();
+
+	const char*	Data() const { return data; }
+	size_t	Size() const { return size; }
+};
+
+
+#endif /* SRCFILE_H_ */
@@ -63,6 +63,27 @@ public:
     
     char GetChar() const {if(IsChar()) return Ctemp; throw "RUNTIME ERROR: Value not a Character";}
     
+    // unchecked access, for code that has proved the type beforehand
+    int RawInt() const { return Itemp; }
+    double RawReal() const { return Rtemp; }
+    bool RawBool() const { return Btemp; }
+    const string& RawString() const { return Stemp; }
+
+    // turn this into an int, real or bool value in place
+    void PutInt(int vi) { T = VINT; Itemp = vi; }
+    void PutReal(double vr) { T = VREAL; Rtemp = vr; }
+    void PutBool(bool vb) { T = VBOOL; Btemp = vb; }
+
+    // where in a Value its type and raw values are, for machine code that
+    // reads and writes them as the unchecked accessors above do
+    struct Layout { size_t type, ival, rval, bval; };
+    static Layout RawLayout() {
+        Value v;
+        const char* at = (const char*) &v;
+        return Layout{ size_t((const char*) &v.T - at), size_t((const char*) &v.Itemp - at),
+                       size_t((const char*) &v.Rtemp - at), size_t((const char*) &v.Btemp - at) };
+    }
+    
     void SetType(ValType type)
     {
     	T = type;
@@ -186,5 +207,9 @@ public:
     }
 };
 
+//where the operators report illegal operands on this thread: cerr, unless a
+//run going on here has given its own stream
+extern thread_local ostream* ValueErrors;
+
 
 #endif
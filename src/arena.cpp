@@ -0,0 +1,42 @@
+/*
+ * arena.cpp
+ * Bump-pointer allocation for the parse-time structures of a SADAL program
+ * CS280 - Spring 2025
+ */
+
+#include "arena.h"
+
+void* Arena::AllocSlow(size_t size, size_t align)
+{
+	//new char[] is aligned for any fundamental type, so a fresh block needs no padding
+	if( size > BLOCK / 4 ) {
+		//a big request gets a block of its own and the current one stays in use
+		blocks.emplace_back(new char[size]);
+		reserved += size;
+		used += size;
+		return blocks.back().get();
+	}
+
+	wasted += left;
+	blocks.emplace_back(new char[BLOCK]);
+	reserved += BLOCK;
+	next = blocks.back().get();
+	left = BLOCK;
+	return Alloc(size, align);
+}
+
+const char* Arena::Text(string_view s)
+{
+	char* copy = (char*) Alloc(s.size() + 1, 1);
+	memcpy(copy, s.data(), s.size());
+	copy[s.size()] = '\0';
+	return copy;
+}
+
+void Arena::Clear()
+{
+	blocks.clear();
+	next = NULL;
+	left = 0;
+	used = reserved = wasted = 0;
+}
@@ -0,0 +1,64 @@
+/*
+ * ast.cpp
+ * Syntax tree nodes of a SADAL program
+ * CS280 - Spring 2025
+ */
+
+#include "ast.h"
+
+ExprLevel Level(const ExprNode* e)
+{
+	switch( e->kind ) {
+	case E_SIGN:
+		return L_STERM;
+	case E_NOT:
+		return L_FACTOR;
+	case E_BINARY:
+		switch( e->op ) {
+		case AND: case OR:
+			return L_EXPR;
+		case EQ: case NEQ: case LTHAN: case LTE: case GTHAN: case GTE:
+			return L_RELATION;
+		case PLUS: case MINUS: case CONCAT:
+			return L_SIMPLE;
+		case MULT: case DIV: case MOD:
+			return L_TERM;
+		default:
+			return L_FACTOR;
+		}
+	default:
+		return L_PRIMARY;
+	}
+}
+
+const char* PassMessage(ExprLevel level)
+{
+	static const char* const msg[] = {
+		NULL,					//Expr
+		NULL,					//Relation
+		"Missing operand",			//SimpleExpr
+		"Missing term after unary sign",	//STerm
+		NULL,					//Term
+		"Missing primary",			//Factor
+		NULL					//Primary
+	};
+	return msg[level];
+}
+
+Value ExprNode::Const() const
+{
+	switch( vtype ) {
+	case VINT:
+		return Value(ival);
+	case VREAL:
+		return Value(rval);
+	case VBOOL:
+		return Value(bval);
+	case VCHAR:
+		return Value(cval);
+	case VSTRING:
+		return Value(string(text, slen));
+	default:
+		return Value();
+	}
+}
@@ -0,0 +1,354 @@
+/*
+ * codecache.cpp
+ * Cache files of compiled SADAL programs
+ * CS280 - Spring 2025
+ *
+ * A cache file is a header, then the arrays of the Code one after another,
+ * each starting at a multiple of 8 bytes, then one table of NUL-terminated
+ * texts that everything else refers to by offset:
+ *	instructions, as they are in memory
+ *	the type and the name of each variable
+ *	constants: a type and its bits, or a string's offset and length
+ *	sites, as they are in memory
+ *	chain links: a message and the next link
+ *	failures: a run of syntax messages
+ *	syntax messages: a line and a message
+ *	texts
+ * It is read by mapping it whole. Nothing in it is trusted before the header
+ * has named the right source and build, the checksum has matched, and every
+ * index in it has been found to be in its bounds.
+ */
+
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <type_traits>
+#include <unordered_map>
+#include <unistd.h>
+
+#include "codecache.h"
+
+static const char MAGIC[8] = { 'S', 'A', 'D', 'A', 'L', 'B', 'C', '\0' };
+//bumped whenever the layout, or what an instruction does, changes
+static const uint32_t FORMAT = 2;
+
+struct Header {
+	char	magic[8];
+	uint32_t	format;
+	uint32_t	opcodes;	//OP_COUNT of the build that wrote it
+	uint64_t	source;		//SourceHash of the source
+	uint64_t	sourceSize;
+	uint64_t	checksum;	//SourceHash of everything after the header
+	int32_t	vars;
+	int32_t	temps;
+	uint32_t	code, consts, sites, chains, failures, msgs, texts;
+	uint32_t	unused;
+};
+
+struct TextRef {
+	uint32_t	at;
+	uint32_t	len;
+};
+
+struct ConstRef {
+	int32_t	type;
+	uint32_t	len;		//string
+	uint64_t	bits;		//a string's offset
+};
+
+struct LinkRef {
+	uint32_t	msg;
+	int32_t	next;
+};
+
+struct MsgRef {
+	int32_t	line;
+	uint32_t	msg;
+};
+
+static_assert(is_trivially_copyable<Instr>::value && is_trivially_copyable<Site>::value,
+	"instructions and sites are stored as they are");
+
+static size_t Aligned(size_t n)
+{
+	return (n + 7) & ~(size_t) 7;
+}
+
+uint64_t SourceHash(const char* data, size_t len)
+{
+	//eight bytes at a time, each mixed in by a multiply and a shift
+	uint64_t h = 0xcbf29ce484222325ull ^ len;
+	size_t i = 0;
+	for( ; i + 8 <= len; i += 8 ) {
+		uint64_t w;
+		memcpy(&w, data + i, 8);
+		h = (h ^ w) * 0xff51afd7ed558ccdull;
+		h ^= h >> 32;
+	}
+	uint64_t w = 0;
+	memcpy(&w, data + i, len - i);
+	h = (h ^ w) * 0xc4ceb9fe1a85ec53ull;
+	h ^= h >> 29;
+	h *= 0xff51afd7ed558ccdull;
+	return h ^ (h >> 32);
+}
+
+//the cache file being written
+class Image {
+	string	bytes;
+	string	texts;
+	unordered_map<string_view, uint32_t>	textIndex;
+
+public:
+	template <class T>
+	void Put(const T* items, size_t count) {
+		bytes.append((const char*) items, count * sizeof(T));
+		bytes.append(Aligned(bytes.size()) - bytes.size(), '\0');
+	}
+	template <class T>
+	void Put(const vector<T>& items) { Put(items.data(), items.size()); }
+
+	//offset of s in the texts, each stored once
+	uint32_t Text(string_view s) {
+		auto found = textIndex.emplace(s, texts.size());
+		if( found.second ) {
+			texts.append(s.data(), s.size());
+			texts += '\0';
+		}
+		return found.first->second;
+	}
+
+	//the texts go last
+	string& Finish() {
+		bytes += texts;
+		return bytes;
+	}
+	size_t Texts() const { return texts.size(); }
+};
+
+bool SaveCode(const Code& code, uint64_t hash, size_t size, const string& path)
+{
+	Image image;
+	image.Text("");		//never an empty table, so it always ends in a NUL
+	image.Put(code.code);
+
+	vector<int32_t> types(code.types.begin(), code.types.end());
+	image.Put(types);
+	vector<TextRef> names;
+	for( string_view name : code.names )
+		names.push_back(TextRef{ image.Text(name), (uint32_t) name.size() });
+	image.Put(names);
+
+	vector<ConstRef> consts;
+	deque<string> strings;
+	for( const Value& v : code.consts ) {
+		ConstRef c = ConstRef();
+		c.type = v.GetType();
+		switch( v.GetType() ) {
+		case VINT:	c.bits = (uint32_t) v.GetInt(); break;
+		case VREAL: {
+			double r = v.GetReal();
+			memcpy(&c.bits, &r, sizeof r);
+			break;
+		}
+		case VBOOL:	c.bits = v.GetBool(); break;
+		case VCHAR:	c.bits = (unsigned char) v.GetChar(); break;
+		default:
+			//the texts are looked up by view, so the copy is kept to the end
+			strings.push_back(v.GetString());
+			c.len = strings.back().size();
+			c.bits = image.Text(strings.back());
+			break;
+		}
+		consts.push_back(c);
+	}
+	image.Put(consts);
+	image.Put(code.sites);
+
+	vector<LinkRef> chains;
+	for( const ChainLink& link : code.chains )
+		chains.push_back(LinkRef{ image.Text(link.msg), link.next });
+	image.Put(chains);
+
+	vector<TextRef> failures;
+	vector<MsgRef> msgs;
+	for( const Span<SyntaxMsg>& errors : code.failures ) {
+		failures.push_back(TextRef{ (uint32_t) msgs.size(), (uint32_t) errors.size() });
+		for( const SyntaxMsg& e : errors )
+			msgs.push_back(MsgRef{ e.line, image.Text(e.msg) });
+	}
+	image.Put(failures);
+	image.Put(msgs);
+
+	Header head = Header();
+	memcpy(head.magic, MAGIC, sizeof MAGIC);
+	head.format = FORMAT;
+	head.opcodes = OP_COUNT;
+	head.source = hash;
+	head.sourceSize = size;
+	head.vars = code.vars;
+	head.temps = code.temps;
+	head.code = code.code.size();
+	head.consts = consts.size();
+	head.sites = code.sites.size();
+	head.chains = chains.size();
+	head.failures = failures.size();
+	head.msgs = msgs.size();
+	head.texts = image.Texts();
+	string& bytes = image.Finish();
+	head.checksum = SourceHash(bytes.data(), bytes.size());
+
+	string tmp = path + "." + to_string(getpid()) + ".tmp";
+	ofstream out(tmp.c_str(), ios::out | ios::binary | ios::trunc);
+	out.write((const char*) &head, sizeof head);
+	out.write(bytes.data(), bytes.size());
+	out.close();
+	if( !out || rename(tmp.c_str(), path.c_str()) != 0 ) {
+		remove(tmp.c_str());
+		return false;
+	}
+	return true;
+}
+
+//whether in can be run in code of that header: its registers, jump target
+//and failure in their bounds, and a site if it can fail
+static bool Valid(const Instr& in, const Header& head, const Site* sites)
+{
+	int regs = head.vars + head.temps + head.consts;
+	auto reg = [&](int r) { return r >= 0 && r < regs; };
+	auto target = [&](int t) { return t >= 0 && t < (int) head.code; };
+
+	if( in.op < 0 || in.op >= OP_COUNT || in.site < -1 || in.site >= (int) head.sites )
+		return false;
+	bool fails = in.op < OP_TAKE ? in.op != OP_MOVE && in.op != OP_PRINT && in.op != OP_JUMP && in.op != OP_HALT
+		: in.op == OP_DIVI || in.op == OP_MODI || in.op == OP_DIVR;
+	if( fails && in.site < 0 )
+		return false;
+
+	switch( in.op ) {
+	case OP_CHECK: case OP_ISINT: case OP_SIGN: case OP_TESTBOOL: case OP_PRINT: case OP_GET: case OP_INIT:
+		return reg(in.a);
+	case OP_MOVE: case OP_TAKE: case OP_NOT: case OP_NOTB: case OP_ASSIGN:
+		return reg(in.a) && reg(in.b);
+	case OP_AND: case OP_OR: case OP_ANDB: case OP_ORB:
+		return reg(in.a) && reg(in.b) && target(in.c);
+	case OP_COND: case OP_CONDB:
+		return reg(in.a) && target(in.c);
+	case OP_JUMP:
+		return target(in.c);
+	case OP_REDEFINED:
+		return sites[in.site].sym >= 0 && sites[in.site].sym < head.vars;
+	case OP_FAIL:
+		return in.a >= 0 && in.a < (int) head.failures;
+	case OP_HALT:
+		return true;
+	default:	//the rest work out a = b op c
+		return reg(in.a) && reg(in.b) && reg(in.c);
+	}
+}
+
+//reads the arrays of a cache file in turn
+class Reader {
+	const char*	at;
+
+public:
+	Reader(const char* at) : at(at) {}
+
+	template <class T>
+	const T* Take(size_t count) {
+		const T* items = (const T*) at;
+		at += Aligned(count * sizeof(T));
+		return items;
+	}
+};
+
+bool CachedCode::Load(const string& path, uint64_t hash, size_t size)
+{
+	if( !file.Open(path) || file.Size() < sizeof(Header) )
+		return false;
+	Header head;
+	memcpy(&head, file.Data(), sizeof head);
+	if( memcmp(head.magic, MAGIC, sizeof MAGIC) != 0 || head.format != FORMAT || head.opcodes != OP_COUNT
+		|| head.source != hash || head.sourceSize != size || head.vars < 0 || head.temps < 0 )
+		return false;
+
+	size_t expect = sizeof head + Aligned(head.code * sizeof(Instr)) + Aligned(head.vars * sizeof(int32_t))
+		+ Aligned(head.vars * sizeof(TextRef)) + Aligned(head.consts * sizeof(ConstRef))
+		+ Aligned(head.sites * sizeof(Site)) + Aligned(head.chains * sizeof(LinkRef))
+		+ Aligned(head.failures * sizeof(TextRef)) + Aligned(head.msgs * sizeof(MsgRef)) + head.texts;
+	if( file.Size() != expect || head.texts == 0 || file.Data()[file.Size() - 1] != '\0' )
+		return false;
+	if( SourceHash(file.Data() + sizeof head, file.Size() - sizeof head) != head.checksum )
+		return false;
+
+	Reader in(file.Data() + sizeof head);
+	const Instr* instrs = in.Take<Instr>(head.code);
+	const int32_t* types = in.Take<int32_t>(head.vars);
+	const TextRef* names = in.Take<TextRef>(head.vars);
+	const ConstRef* consts = in.Take<ConstRef>(head.consts);
+	const Site* sites = in.Take<Site>(head.sites);
+	const LinkRef* chains = in.Take<LinkRef>(head.chains);
+	const TextRef* failures = in.Take<TextRef>(head.failures);
+	const MsgRef* msgRefs = in.Take<MsgRef>(head.msgs);
+	const char* texts = in.Take<char>(head.texts);
+
+	//every index in its bounds, so that no damage gets past here
+	auto text = [&](uint64_t at, uint64_t len) { return at + len < head.texts; };
+	for( uint32_t i = 0; i < head.code; i++ )
+		if( !Valid(instrs[i], head, sites) )
+			return false;
+	//nor may execution run off the end
+	OpCode last = head.code > 0 ? instrs[head.code - 1].op : OP_MOVE;
+	if( last != OP_HALT && last != OP_JUMP && last != OP_FAIL && last != OP_REDEFINED )
+		return false;
+	for( int32_t i = 0; i < head.vars; i++ )
+		if( types[i] < VINT || types[i] > VERR || !text(names[i].at, names[i].len) )
+			return false;
+	for( uint32_t i = 0; i < head.consts; i++ )
+		if( consts[i].type < VINT || consts[i].type >= VERR
+			|| (consts[i].type == VSTRING && !text(consts[i].bits, consts[i].len)) )
+			return false;
+	for( uint32_t i = 0; i < head.sites; i++ )
+		if( sites[i].chain < -1 || sites[i].chain >= (int) head.chains )
+			return false;
+	for( uint32_t i = 0; i < head.chains; i++ )
+		if( !text(chains[i].msg, 0) || chains[i].next < -1 || chains[i].next >= (int) head.chains )
+			return false;
+	for( uint32_t i = 0; i < head.failures; i++ )
+		if( (uint64_t) failures[i].at + failures[i].len > head.msgs )
+			return false;
+	for( uint32_t i = 0; i < head.msgs; i++ )
+		if( !text(msgRefs[i].msg, 0) )
+			return false;
+
+	code.code.assign(instrs, instrs + head.code);
+	code.vars = head.vars;
+	code.temps = head.temps;
+	for( int32_t i = 0; i < head.vars; i++ ) {
+		code.types.push_back((ValType) types[i]);
+		code.names.push_back(string_view(texts + names[i].at, names[i].len));
+	}
+	for( uint32_t i = 0; i < head.consts; i++ ) {
+		const ConstRef& c = consts[i];
+		switch( c.type ) {
+		case VINT:	code.consts.push_back(Value((int) c.bits)); break;
+		case VREAL: {
+			double r;
+			memcpy(&r, &c.bits, sizeof r);
+			code.consts.push_back(Value(r));
+			break;
+		}
+		case VBOOL:	code.consts.push_back(Value(c.bits != 0)); break;
+		case VCHAR:	code.consts.push_back(Value((char) c.bits)); break;
+		default:	code.consts.push_back(Value(string(texts + c.bits, c.len))); break;
+		}
+	}
+	code.sites.assign(sites, sites + head.sites);
+	for( uint32_t i = 0; i < head.chains; i++ )
+		code.chains.push_back(ChainLink{ texts + chains[i].msg, chains[i].next });
+	for( uint32_t i = 0; i < head.msgs; i++ )
+		msgs.push_back(SyntaxMsg{ msgRefs[i].line, texts + msgRefs[i].msg });
+	for( uint32_t i = 0; i < head.failures; i++ )
+		code.failures.push_back(Span<SyntaxMsg>(msgs.data() + failures[i].at, failures[i].len));
+	return true;
+}
@@ -0,0 +1,439 @@
+/*
+ * compile.cpp
+ * Lowers the syntax tree of a SADAL procedure into register bytecode
+ * CS280 - Spring 2025
+ *
+ * Code is laid out in the order the tree evaluator evaluates, so checks run
+ * in the same order. The messages a failure adds on the way out depend only
+ * on where the failing phrase sits in the tree, so each instruction that can
+ * fail is given them here, as its chain.
+ *
+ * A variable only ever holds a value of its declared type, so the type of
+ * most expressions is known here. An operation on operands of a known type
+ * compiles to an instruction for that type, and a check the types make sure
+ * of is left out. Operands that are known not to fit keep the checking
+ * instruction, so the mismatch is reported when execution reaches it, as it
+ * always was.
+ */
+
+#include <cstring>
+
+#include "bytecode.h"
+
+int Code::Chain(const char* msg, int next)
+{
+	//a phrase looks up the same few links as the one before it
+	size_t slot = LinkHash()(make_pair(msg, next)) % 64;
+	if( recent[slot].msg == msg && recent[slot].next == next )
+		return recentAt[slot];
+	auto found = chainIndex.emplace(make_pair(msg, next), chains.size());
+	if( found.second )
+		chains.push_back(ChainLink{ msg, next });
+	recent[slot] = ChainLink{ msg, next };
+	recentAt[slot] = found.first->second;
+	return found.first->second;
+}
+
+int Code::AddConst(const ExprNode* e)
+{
+	uint64_t bits;
+	switch( e->vtype ) {
+	case VINT:	bits = (uint32_t) e->ival; break;
+	case VREAL:	memcpy(&bits, &e->rval, sizeof bits); break;
+	case VBOOL:	bits = e->bval; break;
+	case VCHAR:	bits = (unsigned char) e->cval; break;
+	default: {
+		auto found = stringIndex.emplace(string_view(e->text, e->slen), consts.size());
+		if( found.second )
+			consts.push_back(e->Const());
+		return found.first->second;
+	}
+	}
+	auto found = constIndex.emplace(make_pair(e->vtype, bits), consts.size());
+	if( found.second )
+		consts.push_back(e->Const());
+	return found.first->second;
+}
+
+static int NewSite(Code& code, int line, int chain, int sym = -1, Token type = ERR)
+{
+	Site site = Site();
+	site.line = line;
+	site.sym = sym;
+	site.type = type;
+	site.chain = chain;
+	return code.AddSite(site);
+}
+
+//report errors, then chain
+static void Fail(Code& code, const Span<SyntaxMsg>& errors, int chain)
+{
+	code.failures.push_back(errors);
+	code.Emit(OP_FAIL, code.failures.size() - 1, 0, 0, NewSite(code, 0, chain));
+}
+
+//register holding consts[k] until Compile knows where the constants go
+static int ConstReg(int k)
+{
+	return -1 - k;
+}
+
+//A register and the type its value has whenever the code computing it
+//succeeds, or VERR when that is not known
+struct Reg {
+	int	at;
+	ValType	type;
+};
+
+static ValType TypeOf(Token type)
+{
+	switch( type ) {
+	case INT:	return VINT;
+	case FLOAT:	return VREAL;
+	case BOOL:	return VBOOL;
+	case STRING:	return VSTRING;
+	case CHAR:	return VCHAR;
+	default:	return VERR;
+	}
+}
+
+static Reg Expr(Code& code, const ExprNode* e, int chain);
+
+//e found where the grammar wanted a phrase of level want: on failure the
+//rules between add their messages, then msg, then the ones around (see
+//Operand in exec.cpp)
+static Reg Operand(Code& code, const ExprNode* e, int want, const char* msg, int around)
+{
+	int chain = around;
+	int level = Level(e);
+	if( level >= want ) {
+		if( msg != NULL )
+			chain = code.Chain(msg, chain);
+		for( int l = want; l < level; l++ )
+			if( PassMessage((ExprLevel) l) != NULL )
+				chain = code.Chain(PassMessage((ExprLevel) l), chain);
+	}
+	return Expr(code, e, chain);
+}
+
+static OpCode BinaryOp(Token op)
+{
+	switch( op ) {
+	case PLUS:	return OP_ADD;
+	case MINUS:	return OP_SUB;
+	case CONCAT:	return OP_CONCAT;
+	case MULT:	return OP_MUL;
+	case DIV:	return OP_DIV;
+	case MOD:	return OP_MOD;
+	case EQ:	return OP_EQ;
+	case NEQ:	return OP_NEQ;
+	case LTHAN:	return OP_LTHAN;
+	case LTE:	return OP_LTE;
+	case GTHAN:	return OP_GTHAN;
+	case GTE:	return OP_GTE;
+	default:	return OP_EXP;
+	}
+}
+
+//the type the Value operator gives operands of the types given, as far as it
+//depends on the types alone
+static ValType ResultType(OpCode op, ValType left, ValType right)
+{
+	bool same = left == right && left != VERR;
+	bool numeric = same && (left == VINT || left == VREAL);
+	switch( op ) {
+	case OP_ADD: case OP_SUB: case OP_MUL: case OP_DIV:
+		return numeric ? left : VERR;
+	case OP_MOD:
+		return same && left == VINT ? VINT : VERR;
+	case OP_EQ: case OP_NEQ:
+		return same ? VBOOL : VERR;
+	case OP_LTHAN: case OP_LTE: case OP_GTHAN: case OP_GTE:
+		return same && left != VBOOL ? VBOOL : VERR;
+	case OP_CONCAT:
+		return (left == VSTRING || left == VCHAR) && (right == VSTRING || right == VCHAR) ? VSTRING : VERR;
+	default:
+		return VERR;
+	}
+}
+
+//the instruction for op on operands of the same type, which needs no checks
+//of type, or the checking one
+static OpCode Specialized(OpCode op, ValType type)
+{
+	static_assert(OP_GTE - OP_ADD == 12, "binary operators in Token order");
+	static const OpCode ints[] = { OP_ADDI, OP_SUBI, OP_CONCAT, OP_MULI, OP_DIVI, OP_MODI, OP_EXP,
+		OP_EQI, OP_NEQI, OP_LTHANI, OP_LTEI, OP_GTHANI, OP_GTEI };
+	static const OpCode reals[] = { OP_ADDR, OP_SUBR, OP_CONCAT, OP_MULR, OP_DIVR, OP_MOD, OP_EXP,
+		OP_EQR, OP_NEQR, OP_LTHANR, OP_LTER, OP_GTHANR, OP_GTER };
+	switch( type ) {
+	case VINT:
+		return ints[op - OP_ADD];
+	case VREAL:
+		return reals[op - OP_ADD];
+	case VSTRING:
+		return op == OP_EQ ? OP_EQS : op == OP_NEQ ? OP_NEQS : op == OP_CONCAT ? OP_CONCATS : op;
+	default:
+		return op;
+	}
+}
+
+static Reg Binary(Code& code, const ExprNode* e, int chain)
+{
+	int live = code.live;
+	Reg left, right;
+	switch( Level(e) ) {
+	case L_EXPR: {
+		//AND, OR: the right operand only runs when it decides the result
+		left = Operand(code, e->left, L_RELATION, NULL, chain);
+		code.live = live;
+		int dst = code.Temp();
+		int skip;
+		if( left.type == VBOOL )
+			skip = code.Emit(e->op == AND ? OP_ANDB : OP_ORB, dst, left.at);
+		else
+			skip = code.Emit(e->op == AND ? OP_AND : OP_OR, dst, left.at, 0, NewSite(code, e->line2, chain));
+		right = Operand(code, e->right, L_RELATION, "Missing expression after logical operator", chain);
+		if( right.type != VBOOL )
+			code.Emit(OP_TESTBOOL, right.at, 0, 0, NewSite(code, e->line, chain));
+		code.Emit(OP_MOVE, dst, right.at);
+		code.Patch(skip);
+		code.live = live + 1;
+		return Reg{ dst, VBOOL };
+	}
+	case L_RELATION:
+		left = Operand(code, e->left, L_SIMPLE, NULL, chain);
+		right = Operand(code, e->right, L_SIMPLE, "Missing expression after relational operator", chain);
+		break;
+	case L_SIMPLE:
+		left = Operand(code, e->left, L_STERM, "Missing operand", chain);
+		right = Operand(code, e->right, L_STERM, "Missing operand after operator", chain);
+		break;
+	case L_TERM:
+		left = Operand(code, e->left, L_FACTOR, NULL, chain);
+		right = Operand(code, e->right, L_FACTOR, "Missing factor after operator", chain);
+		break;
+	default:
+		left = Operand(code, e->left, L_PRIMARY, "Missing primary", chain);
+		right = Operand(code, e->right, L_PRIMARY, "Missing exponent after **", chain);
+		break;
+	}
+	//the operands are read before the result is written, so it may go in
+	//the temporary of the left one
+	code.live = live;
+	int dst = code.Temp();
+	OpCode op = BinaryOp(e->op);
+	ValType type = ResultType(op, left.type, right.type);
+	if( left.type == right.type )
+		op = Specialized(op, left.type);
+	//division and MOD still check for zero
+	bool checks = op < OP_TAKE || op == OP_DIVI || op == OP_MODI || op == OP_DIVR;
+	code.Emit(op, dst, left.at, right.at, checks ? NewSite(code, e->line, chain) : -1);
+	return Reg{ dst, type };
+}
+
+//chain: the messages added when e fails
+static Reg Expr(Code& code, const ExprNode* e, int chain)
+{
+	switch( e->kind ) {
+	case E_CONST:
+		return Reg{ ConstReg(code.AddConst(e)), e->vtype };
+
+	case E_VAR:
+		code.Emit(OP_CHECK, e->slot, 0, 0, NewSite(code, e->line, chain));
+		return Reg{ e->slot, code.types[e->slot] };
+
+	case E_INDEX: {
+		int live = code.live;
+		Reg str = Expr(code, e->left, chain);
+		int dst = code.Temp();
+		Reg lo = Operand(code, e->right, L_SIMPLE, "Missing start index in range", chain);
+		if( lo.type != VINT )
+			code.Emit(OP_ISINT, lo.at, 0, 0, NewSite(code, e->line2, chain));
+		Reg val = Reg{ dst, VCHAR };
+		if( e->hi != NULL ) {
+			Reg hi = Operand(code, e->hi, L_SIMPLE, "Missing end index in range", chain);
+			code.Emit(OP_MOVE, dst, str.at);
+			code.Emit(OP_SLICE, dst, lo.at, hi.at, NewSite(code, e->line, chain));
+			val.type = VSTRING;
+		}
+		else
+			code.Emit(OP_INDEX, dst, str.at, lo.at, NewSite(code, e->line, chain));
+		code.live = live + 1;
+		return val;
+	}
+
+	case E_PAREN:
+		return Operand(code, e->left, L_EXPR, "Invalid expression in parentheses", chain);
+
+	case E_SIGN: {
+		Reg val = Operand(code, e->left, L_TERM, "Missing term after unary sign", chain);
+		if( val.type != VINT && val.type != VREAL )
+			code.Emit(OP_SIGN, val.at, 0, 0, NewSite(code, e->line, chain));
+		return val;
+	}
+
+	case E_NOT: {
+		int live = code.live;
+		Reg val = Operand(code, e->left, L_PRIMARY, "Missing primary after NOT", chain);
+		code.live = live;
+		int dst = code.Temp();
+		if( val.type == VBOOL )
+			code.Emit(OP_NOTB, dst, val.at);
+		else
+			code.Emit(OP_NOT, dst, val.at, 0, NewSite(code, e->line, chain));
+		return Reg{ dst, VBOOL };
+	}
+
+	case E_BINARY:
+		return Binary(code, e, chain);
+	}
+	return Reg{ ConstReg(0), VERR };
+}
+
+//code to evaluate e as an Operand, of which nothing stays live
+static Reg Evaluate(Code& code, const ExprNode* e, int want, const char* msg, int around)
+{
+	Reg val = Operand(code, e, want, msg, around);
+	code.live = 0;
+	return val;
+}
+
+static bool IsTemp(const Code& code, int reg)
+{
+	return reg >= code.vars;
+}
+
+static void StmtList(Code& code, const Span<StmtNode*>& list, int around);
+
+static void IfStmt(Code& code, const StmtNode* s, int chain)
+{
+	vector<int> ends;
+	for( size_t i = 0; i < s->clauses.size(); i++ ) {
+		const IfClause& clause = s->clauses[i];
+		if( !clause.errors.empty() ) {
+			Fail(code, clause.errors, chain);
+			break;
+		}
+		if( clause.cond == NULL ) {
+			StmtList(code, clause.body, chain);
+			break;
+		}
+		Reg cond = Evaluate(code, clause.cond, L_EXPR, i == 0 ? "Missing or invalid condition after IF"
+								: "Missing or invalid condition after ELSIF", chain);
+		int next;
+		if( cond.type == VBOOL )
+			next = code.Emit(OP_CONDB, cond.at);
+		else
+			next = code.Emit(OP_COND, cond.at, 0, 0, NewSite(code, clause.line, chain, i));
+		StmtList(code, clause.body, chain);
+		ends.push_back(code.Emit(OP_JUMP));
+		code.Patch(next);
+	}
+	for( int end : ends )
+		code.Patch(end);
+}
+
+static void Stmt(Code& code, const StmtNode* s, int chain)
+{
+	switch( s->kind ) {
+	case S_PRINT: {
+		Reg val = Evaluate(code, s->expr, L_EXPR, "Invalid expression in print statement", chain);
+		code.Emit(OP_PRINT, val.at, s->newline);
+		break;
+	}
+
+	case S_GET:
+		code.Emit(OP_GET, s->slot, 0, 0, NewSite(code, s->line, chain, -1, s->type));
+		break;
+
+	case S_ASSIGN: {
+		Reg val = Evaluate(code, s->expr, L_EXPR, "Invalid expression in assignment", chain);
+		if( val.type != VERR && val.type == TypeOf(s->type) )
+			code.Emit(IsTemp(code, val.at) ? OP_TAKE : OP_MOVE, s->slot, val.at);
+		else if( s->slot < 0 )	//never declared: the check fails, nothing is stored
+			code.Emit(OP_ASSIGN, val.at, val.at, 0, NewSite(code, s->line, chain, -1, s->type));
+		else
+			code.Emit(OP_ASSIGN, s->slot, val.at, IsTemp(code, val.at), NewSite(code, s->line, chain, -1, s->type));
+		break;
+	}
+
+	case S_IF:
+		IfStmt(code, s, chain);
+		break;
+
+	case S_ERROR:
+		Fail(code, s->errors, chain);
+		break;
+	}
+}
+
+static void StmtList(Code& code, const Span<StmtNode*>& list, int around)
+{
+	int chain = code.Chain("Syntactic error in statement list.", around);
+	for( const StmtNode* s : list )
+		Stmt(code, s, chain);
+}
+
+//false: d always fails, so nothing after it runs
+static bool Decl(Code& code, const DeclNode* d, int chain)
+{
+	if( !d->errors.empty() ) {
+		Fail(code, d->errors, chain);
+		return false;
+	}
+	Reg val = Reg{ 0, VERR };
+	if( d->init != NULL ) {
+		val = Evaluate(code, d->init, L_EXPR, "Invalid initialization expression", chain);
+		if( val.type == VERR || val.type != TypeOf(d->type) )
+			code.Emit(OP_INIT, val.at, 0, 0, NewSite(code, d->initLine, chain, -1, d->type));
+	}
+	if( d->redefined >= 0 ) {
+		code.Emit(OP_REDEFINED, 0, 0, 0, NewSite(code, d->line, chain, d->redefined));
+		return false;
+	}
+	if( d->init != NULL )
+		for( int slot : d->slots )
+			code.Emit(OP_MOVE, slot, val.at);
+	return true;
+}
+
+static void Procedure(Code& code, const Program& prog)
+{
+	if( !prog.headErrors.empty() ) {
+		Fail(code, prog.headErrors, -1);
+		return;
+	}
+
+	int proc = code.Chain("Incorrect Procedure Definition.", code.Chain("Incorrect Procedure Body", -1));
+	for( size_t i = 0; i < prog.decls.size(); i++ ) {
+		int chain = code.Chain(i == 0 ? "Non-recognizable Declaration Part." : "Invalid declaration.", proc);
+		if( !Decl(code, prog.decls[i], chain) )
+			return;
+	}
+	StmtList(code, prog.body, proc);
+	if( !prog.bodyErrors.empty() ) {
+		Fail(code, prog.bodyErrors, proc);
+		return;
+	}
+	code.Emit(OP_HALT);
+}
+
+void Compile(const Program& prog, Code& code)
+{
+	code.vars = prog.Frame();
+	for( int slot = 0; slot < code.vars; slot++ )
+		code.types.push_back(TypeOf(prog.types[slot]));
+	code.names = prog.names;
+	Procedure(code, prog);
+
+	//constants go after the temporaries, now they are all counted
+	for( Instr& in : code.code ) {
+		if( in.a < 0 )
+			in.a = code.ConstBase() - 1 - in.a;
+		if( in.b < 0 )
+			in.b = code.ConstBase() - 1 - in.b;
+		if( in.c < 0 )
+			in.c = code.ConstBase() - 1 - in.c;
+	}
+}
@@ -0,0 +1,813 @@
+/*
+ * emitcpp.cpp
+ * Translates the bytecode of a SADAL procedure into a C++ program
+ * CS280 - Spring 2025
+ *
+ * Each instruction becomes the C++ statements doing what the VM does for it,
+ * with the same checks and messages, and a jump a goto, so the program
+ * prints what the interpreter prints. A variable of a declared type is a
+ * local of that type, with a flag for whether it has been assigned if it is
+ * ever checked for that; a constant is written out where it is used. Only
+ * the temporaries, whose types the compiler could not always tell, are
+ * values of any type, with the operators of Value.
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+
+#include "emitcpp.h"
+
+//what every generated program starts with: a value of any type and its
+//operators, output and input as Value and ReadInput do them, and errors
+static const char* const Support = R"SADAL(
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <utility>
+
+using namespace std;
+
+enum Type { ERR, INT, REAL, BOOL, CHAR, STRING };
+
+//a value whose type is only known when the program runs
+struct V {
+	Type	t;
+	int	i;
+	double	r;
+	bool	b;
+	char	c;
+	string	s;
+
+	V() : t(ERR), i(0), r(0), b(false), c(0) {}
+	V(int v) : t(INT), i(v), r(0), b(false), c(0) {}
+	V(double v) : t(REAL), i(0), r(v), b(false), c(0) {}
+	V(bool v) : t(BOOL), i(0), r(0), b(v), c(0) {}
+	V(char v) : t(CHAR), i(0), r(0), b(false), c(v) {}
+	V(string v) : t(STRING), i(0), r(0), b(false), c(0), s(move(v)) {}
+
+	void PutInt(int v) { t = INT; i = v; }
+	void PutReal(double v) { t = REAL; r = v; }
+	void PutBool(bool v) { t = BOOL; b = v; }
+	void PutString(string v) { t = STRING; s = move(v); }
+};
+
+//integers wrap around on overflow
+inline int AddI(int x, int y) { return (int) ((unsigned) x + (unsigned) y); }
+inline int SubI(int x, int y) { return (int) ((unsigned) x - (unsigned) y); }
+inline int MulI(int x, int y) { return (int) ((unsigned) x * (unsigned) y); }
+
+inline V Complain(const char* what)
+{
+	cerr << "Run-Time Error: " << what << endl;
+	return V();
+}
+
+inline V Illegal(const char* op)
+{
+	cerr << "Run-Time Error: Illegal operands for " << op << endl;
+	return V();
+}
+
+inline V Add(const V& x, const V& y)
+{
+	if( x.t == INT && y.t == INT )
+		return V(AddI(x.i, y.i));
+	if( x.t == REAL && y.t == REAL )
+		return V(x.r + y.r);
+	return Illegal("+");
+}
+
+inline V Sub(const V& x, const V& y)
+{
+	if( x.t == INT && y.t == INT )
+		return V(SubI(x.i, y.i));
+	if( x.t == REAL && y.t == REAL )
+		return V(x.r - y.r);
+	return Illegal("-");
+}
+
+inline V Mul(const V& x, const V& y)
+{
+	if( x.t == INT && y.t == INT )
+		return V(MulI(x.i, y.i));
+	if( x.t == REAL && y.t == REAL )
+		return V(x.r * y.r);
+	return Illegal("*");
+}
+
+inline V Div(const V& x, const V& y)
+{
+	if( x.t == INT && y.t == INT )
+		return y.i == 0 ? Complain("Division by zero") : V(x.i / y.i);
+	if( x.t == REAL && y.t == REAL )
+		return y.r == 0.0 ? Complain("Division by zero") : V(x.r / y.r);
+	return Illegal("/");
+}
+
+//a relation of operands of the same type; booleans are only equal or not
+template <class Rel>
+inline V Compare(const V& x, const V& y, const char* op, bool ordered, Rel rel)
+{
+	if( x.t == y.t ) {
+		switch( x.t ) {
+		case INT:	return V(rel(x.i, y.i));
+		case REAL:	return V(rel(x.r, y.r));
+		case BOOL:	if( !ordered ) return V(rel(x.b, y.b)); break;
+		case CHAR:	return V(rel(x.c, y.c));
+		case STRING:	return V(rel(x.s, y.s));
+		default:	break;
+		}
+	}
+	return Illegal(op);
+}
+
+inline V Eq(const V& x, const V& y) { return Compare(x, y, "==", false, [](const auto& p, const auto& q) { return p == q; }); }
+inline V Neq(const V& x, const V& y) { return Compare(x, y, "!=", false, [](const auto& p, const auto& q) { return p != q; }); }
+inline V Lt(const V& x, const V& y) { return Compare(x, y, "<", true, [](const auto& p, const auto& q) { return p < q; }); }
+inline V Gt(const V& x, const V& y) { return Compare(x, y, ">", true, [](const auto& p, const auto& q) { return p > q; }); }
+//the interpreter names these two > as well
+inline V Lte(const V& x, const V& y) { return Compare(x, y, ">", true, [](const auto& p, const auto& q) { return p <= q; }); }
+inline V Gte(const V& x, const V& y) { return Compare(x, y, ">", true, [](const auto& p, const auto& q) { return p >= q; }); }
+
+inline V Concat(const V& x, const V& y)
+{
+	if( (x.t != STRING && x.t != CHAR) || (y.t != STRING && y.t != CHAR) )
+		return Illegal("Concat");
+	return V((x.t == STRING ? x.s : string(1, x.c)) + (y.t == STRING ? y.s : string(1, y.c)));
+}
+
+inline V Exp(const V& x, const V& y)
+{
+	if( x.t != REAL || y.t != REAL )
+		return Illegal("Exp");
+	if( y.r == 0.0 )
+		return V(1.0);
+	if( x.r == 0.0 && y.r > 0 )
+		return V(0.0);
+	if( x.r == 0.0 && y.r < 0 )
+		return Complain("Zero raised to negative power");
+	if( y.r < 0 )
+		return V(1.0 / pow(x.r, -y.r));
+	return V(pow(x.r, y.r));
+}
+
+inline void Put(int v) { cout << v; }
+inline void Put(double v) { cout << fixed << showpoint << setprecision(2) << v; }
+inline void Put(bool v) { cout << (v ? "true" : "false"); }
+inline void Put(char v) { cout << v; }
+inline void Put(const string& v) { cout << v; }
+
+inline void Put(const V& v)
+{
+	switch( v.t ) {
+	case INT:	Put(v.i); break;
+	case REAL:	Put(v.r); break;
+	case BOOL:	Put(v.b); break;
+	case CHAR:	Put(v.c); break;
+	case STRING:	Put(v.s); break;
+	default:	cout << "ERROR"; break;
+	}
+}
+
+static int errors = 0;
+static int errLine = 0;		//line of the last error
+
+inline void Error(int line, const string& msg)
+{
+	++errors;
+	errLine = line;
+	cout << line << ": " << msg << endl;
+}
+
+inline bool Get(int line, int& v)
+{
+	int x;
+	if( !(cin >> x) ) {
+		Error(line, "Invalid integer input");
+		return false;
+	}
+	v = x;
+	return true;
+}
+
+inline bool Get(int line, double& v)
+{
+	double x;
+	if( !(cin >> x) ) {
+		Error(line, "Invalid float input");
+		return false;
+	}
+	v = x;
+	return true;
+}
+
+inline bool Get(int line, bool& v)
+{
+	string word;
+	cin >> word;
+	transform(word.begin(), word.end(), word.begin(), ::tolower);
+	if( word != "true" && word != "false" ) {
+		Error(line, "Invalid boolean input - must be 'true' or 'false'");
+		return false;
+	}
+	v = word == "true";
+	return true;
+}
+
+inline bool Get(int line, char& v)
+{
+	char x;
+	if( !(cin >> x) ) {
+		Error(line, "Invalid character input");
+		return false;
+	}
+	v = x;
+	return true;
+}
+
+inline bool Get(int line, string& v)
+{
+	getline(cin, v);
+	return true;
+}
+
+//replace str by str(start), or by str(start..*end) when end is given
+inline bool Substring(int line, V& str, int start, const int* end)
+{
+	if( str.t != STRING ) {
+		Error(line, "Not a string");
+		return false;
+	}
+	int len = str.s.length();
+	if( end != nullptr ? start < 0 || *end >= len || start > *end : start < 0 || start >= len ) {
+		Error(line, "String index out of bounds");
+		return false;
+	}
+	if( end != nullptr )
+		str.s = str.s.substr(start, *end - start + 1);
+	else
+		str = V(str.s[start]);
+	return true;
+}
+
+//the messages of the rules a failing phrase was nested in, one link each
+struct Link {
+	const char*	msg;
+	int	next;
+};
+)SADAL";
+
+//what follows the procedure
+static const char* const Main = R"SADAL(
+int main()
+{
+	if( !Run() )
+		cout << "\nUnsuccessful Interpretation " << endl << "Number of Errors " << errors << endl;
+	else
+		cout << "\nSuccessful Execution" << endl;
+	return 0;
+}
+)SADAL";
+
+//text as a C++ string literal; anything but printable ASCII escaped in
+//octal, three digits, so no digit after it is taken in
+static string Quote(string_view text)
+{
+	string lit = "\"";
+	for( unsigned char ch : text ) {
+		if( ch == '"' || ch == '\\' )
+			lit += '\\', lit += ch;
+		else if( ch >= ' ' && ch < 127 )
+			lit += ch;
+		else {
+			char esc[5];
+			snprintf(esc, sizeof esc, "\\%03o", ch);
+			lit += esc;
+		}
+	}
+	return lit + "\"";
+}
+
+//C++ of a constant of type int, real, bool or char, as exact as the value
+static string Literal(const Value& v)
+{
+	char buf[64];
+	switch( v.GetType() ) {
+	case VINT:
+		if( v.RawInt() == INT32_MIN )
+			return "(-2147483647 - 1)";
+		return v.RawInt() < 0 ? "(" + to_string(v.RawInt()) + ")" : to_string(v.RawInt());
+	case VREAL:
+		if( isinf(v.RawReal()) )
+			return v.RawReal() < 0 ? "(-HUGE_VAL)" : "HUGE_VAL";
+		if( isnan(v.RawReal()) )
+			return signbit(v.RawReal()) ? "(-NAN)" : "NAN";
+		//17 digits read back as the same double
+		snprintf(buf, sizeof buf, "%.17g", v.RawReal());
+		if( string(buf).find_first_of(".e") == string::npos )
+			strcat(buf, ".0");
+		return signbit(v.RawReal()) ? string("(") + buf + ")" : buf;
+	case VBOOL:
+		return v.RawBool() ? "true" : "false";
+	case VCHAR:
+		return "char(" + to_string((int) (unsigned char) v.GetChar()) + ")";
+	default:
+		return "V()";
+	}
+}
+
+static const char* TypeName(ValType type)
+{
+	switch( type ) {
+	case VINT:	return "int";
+	case VREAL:	return "double";
+	case VBOOL:	return "bool";
+	case VCHAR:	return "char";
+	case VSTRING:	return "string";
+	default:	return "V";
+	}
+}
+
+//the run-time Type of a V of type
+static const char* TypeTag(ValType type)
+{
+	switch( type ) {
+	case VINT:	return "INT";
+	case VREAL:	return "REAL";
+	case VBOOL:	return "BOOL";
+	case VCHAR:	return "CHAR";
+	case VSTRING:	return "STRING";
+	default:	return "ERR";
+	}
+}
+
+//the field of a V holding a value of type
+static const char* Field(ValType type)
+{
+	switch( type ) {
+	case VINT:	return ".i";
+	case VREAL:	return ".r";
+	case VBOOL:	return ".b";
+	case VCHAR:	return ".c";
+	default:	return ".s";
+	}
+}
+
+static ValType TypeOf(Token type)
+{
+	switch( type ) {
+	case INT:	return VINT;
+	case FLOAT:	return VREAL;
+	case BOOL:	return VBOOL;
+	case STRING:	return VSTRING;
+	case CHAR:	return VCHAR;
+	default:	return VERR;
+	}
+}
+
+//conditions in C++, made simpler where a side is known
+static string And(const string& x, const string& y)
+{
+	if( x == "false" || y == "false" )
+		return "false";
+	return x == "true" ? y : y == "true" ? x : x + " && " + y;
+}
+
+static string Or(const string& x, const string& y)
+{
+	if( x == "true" || y == "true" )
+		return "true";
+	return x == "false" ? y : y == "false" ? x : "(" + x + ") || (" + y + ")";
+}
+
+static string Not(const string& x)
+{
+	return x == "true" ? "false" : x == "false" ? "true" : "!(" + x + ")";
+}
+
+namespace {
+
+class Emitter {
+	const Code&	code;
+	ostringstream	body;
+	vector<bool>	used;		//registers the code names
+	vector<bool>	read;		//registers whose values it uses
+	vector<bool>	checked;	//variables checked for being assigned
+	vector<bool>	target;		//instructions jumped to
+
+public:
+	Emitter(const Code& code) : code(code), used(code.Registers()), read(code.Registers()), checked(code.vars), target(code.code.size() + 1) {}
+
+	void Program(const string& name, ostream& out);
+
+private:
+	bool IsVar(int r) const { return r < code.vars; }
+	bool IsConst(int r) const { return r >= code.ConstBase(); }
+
+	//the type of the value in r wherever it is read, when the C++ keeps it
+	//as that type; VERR for a V
+	ValType Kept(int r) const {
+		if( IsConst(r) )
+			return code.consts[r - code.ConstBase()].GetType();
+		return IsVar(r) ? code.types[r] : VERR;
+	}
+
+	string Name(int r) {
+		used[r] = true;
+		if( IsConst(r) )
+			return "k" + to_string(r - code.ConstBase());
+		if( !IsVar(r) )
+			return "t" + to_string(r - code.vars);
+		string name = "v" + to_string(r) + "_";
+		for( char ch : code.names[r] )
+			if( isalnum((unsigned char) ch) || ch == '_' )
+				name += ch;
+		return name;
+	}
+
+	//r, known to hold a value of type, as a C++ value of that type
+	string Read(int r, ValType type) {
+		read[r] = true;
+		if( Kept(r) == VERR )
+			return Name(r) + Field(type);
+		if( IsConst(r) && type != VSTRING )
+			return Literal(code.consts[r - code.ConstBase()]);
+		return IsConst(r) ? Name(r) + ".s" : Name(r);
+	}
+
+	//r as a V
+	string ReadV(int r) {
+		read[r] = true;
+		if( IsConst(r) || Kept(r) == VERR )
+			return Name(r);
+		return "V(" + Name(r) + ")";
+	}
+
+	//whether r holds a value of type
+	string Is(int r, ValType type) {
+		if( Kept(r) != VERR )
+			return type != VERR && Kept(r) == type ? "true" : "false";
+		return type == VERR ? "false" : Name(r) + ".t == " + TypeTag(type);
+	}
+
+	//whether r, known to hold a number of type, is zero
+	string Zero(int r, ValType type) {
+		if( IsConst(r) )
+			return (type == VINT ? code.consts[r - code.ConstBase()].RawInt() == 0
+					: code.consts[r - code.ConstBase()].RawReal() == 0.0) ? "true" : "false";
+		return Read(r, type) + (type == VINT ? " == 0" : " == 0.0");
+	}
+
+	//the statements setting r to the C++ value of type
+	string Write(int r, ValType type, const string& val) {
+		if( Kept(r) == VERR ) {
+			switch( type ) {
+			case VINT:	return Name(r) + ".PutInt(" + val + ");";
+			case VREAL:	return Name(r) + ".PutReal(" + val + ");";
+			case VBOOL:	return Name(r) + ".PutBool(" + val + ");";
+			case VSTRING:	return Name(r) + ".PutString(" + val + ");";
+			default:	return Name(r) + " = V(" + val + ");";
+			}
+		}
+		string assign = Name(r) + " = " + val + ";";
+		if( IsVar(r) && checked[r] )
+			assign += " set" + to_string(r) + " = true;";
+		return assign;
+	}
+
+	//r = V val, where a variable is only ever given a value of its type
+	string WriteV(int r, const string& val) {
+		if( Kept(r) == VERR )
+			return Name(r) + " = " + val + ";";
+		return Write(r, Kept(r), "(" + val + ")" + Field(Kept(r)));
+	}
+
+	//r = s; take: s is a temporary, and its value can be moved
+	string Store(int r, int s, bool take) {
+		if( Kept(r) == VERR ) {
+			string val = ReadV(s);
+			return WriteV(r, take && Kept(s) == VERR ? "move(" + val + ")" : val);
+		}
+		string val = Read(s, Kept(r));
+		if( take && Kept(s) == VERR && Kept(r) == VSTRING )
+			val = "move(" + val + ")";
+		return Write(r, Kept(r), val);
+	}
+
+	//run r's value through the output
+	string Print(int r) {
+		read[r] = true;
+		if( IsConst(r) && Kept(r) == VSTRING )
+			return "Put(" + Name(r) + ".s);";
+		return "Put(" + (IsConst(r) ? Read(r, Kept(r)) : Name(r)) + ");";
+	}
+
+	string Jump(int to) {
+		target[to] = true;
+		return "goto L" + to_string(to) + ";";
+	}
+
+	//unwinding after the error of site has been reported
+	string Unwind(int site) {
+		return "return Fail(" + to_string(code.sites[site].chain) + ");";
+	}
+
+	//if cond, report msg at site and unwind
+	void Check(const string& cond, int site, const string& msg) {
+		if( cond == "false" )
+			return;
+		if( cond != "true" )
+			body << "\tif( " << cond << " ) {\n\t";
+		body << "\tError(" << code.sites[site].line << ", " << Quote(msg) << ");\n";
+		body << (cond != "true" ? "\t\t" : "\t") << Unwind(site) << "\n";
+		if( cond != "true" )
+			body << "\t}\n";
+	}
+
+	void Instruction(const Instr& in);
+};
+
+void Emitter::Instruction(const Instr& in)
+{
+	static const char* const generic[] = { "Add", "Sub", "Concat", "Mul", "Div", "Mod", "Exp",
+		"Eq", "Neq", "Lt", "Lte", "Gt", "Gte" };
+	static const char* const integer[] = { "AddI(%s, %s)", "SubI(%s, %s)", "MulI(%s, %s)", "%s / %s", "%s %% %s" };
+	static const char* const relation[] = { "%s == %s", "%s != %s", "%s < %s", "%s <= %s", "%s > %s", "%s >= %s" };
+	static const char* const arith[] = { "%s + %s", "%s - %s", "%s * %s", "%s / %s" };
+	char buf[512];
+	auto binary = [&](const char* form, ValType type) {
+		string b = Read(in.b, type), c = Read(in.c, type);
+		snprintf(buf, sizeof buf, form, b.c_str(), c.c_str());
+		return string(buf);
+	};
+	const Site* site = in.site >= 0 ? &code.sites[in.site] : NULL;
+
+	switch( in.op ) {
+	case OP_MOVE:
+	case OP_TAKE:
+		body << "\t" << Store(in.a, in.b, in.op == OP_TAKE) << "\n";
+		break;
+
+	case OP_CHECK:
+		used[in.a] = true;
+		Check(Kept(in.a) == VERR ? Name(in.a) + ".t == ERR" : "!set" + to_string(in.a), in.site,
+			"Uninitialized variable: " + string(code.names[in.a]));
+		break;
+
+	case OP_ISINT:
+		Check(Not(Is(in.a, VINT)), in.site, "Range indices must be integers");
+		break;
+
+	case OP_INDEX:
+		body << "\t{\n\t\tV str = " << ReadV(in.b) << ";\n";
+		body << "\t\tif( !Substring(" << site->line << ", str, " << Read(in.c, VINT) << ", nullptr) )\n";
+		body << "\t\t\t" << Unwind(in.site) << "\n";
+		body << "\t\t" << WriteV(in.a, "move(str)") << "\n\t}\n";
+		break;
+
+	case OP_SLICE:
+		Check(Not(Is(in.c, VINT)), in.site, "Range indices must be integers");
+		Check(Read(in.b, VINT) + " > " + Read(in.c, VINT), in.site, "Invalid range - start index > end index");
+		body << "\t{\n\t\tint end = " << Read(in.c, VINT) << ";\n";
+		body << "\t\tif( !Substring(" << site->line << ", " << Name(in.a) << ", " << Read(in.b, VINT) << ", &end) )\n";
+		body << "\t\t\t" << Unwind(in.site) << "\n\t}\n";
+		break;
+
+	case OP_SIGN:
+		Check(And(Not(Is(in.a, VINT)), Not(Is(in.a, VREAL))), in.site,
+			"Run-Time Error-Illegal operand type for sign operation");
+		break;
+
+	case OP_NOT:
+		Check(Not(Is(in.b, VBOOL)), in.site, "Run-Time Error-Illegal operand type for NOT operation");
+		if( Is(in.b, VBOOL) != "false" )
+			body << "\t" << Write(in.a, VBOOL, "!" + Read(in.b, VBOOL)) << "\n";
+		break;
+
+	case OP_ADD: case OP_SUB: case OP_CONCAT: case OP_MUL:
+	case OP_EQ: case OP_NEQ: case OP_LTHAN: case OP_LTE: case OP_GTHAN: case OP_GTE:
+		body << "\t" << WriteV(in.a, string(generic[in.op - OP_ADD]) + "(" + ReadV(in.b) + ", " + ReadV(in.c) + ")") << "\n";
+		break;
+
+	case OP_DIV:
+		Check(Or(And(Is(in.c, VINT), Zero(in.c, VINT)), And(Is(in.c, VREAL), Zero(in.c, VREAL))),
+			in.site, "Run-Time Error-Illegal division by zero");
+		body << "\t" << WriteV(in.a, "Div(" + ReadV(in.b) + ", " + ReadV(in.c) + ")") << "\n";
+		break;
+
+	case OP_MOD:
+		Check(Or(Not(Is(in.b, VINT)), Not(Is(in.c, VINT))), in.site, "Run-Time Error-Illegal operand types for MOD");
+		if( Is(in.b, VINT) == "false" || Is(in.c, VINT) == "false" )
+			break;
+		Check(Zero(in.c, VINT), in.site, "Run-Time Error-Illegal mod by zero");
+		if( Zero(in.c, VINT) == "true" )
+			break;
+		body << "\t" << Write(in.a, VINT, binary(integer[4], VINT)) << "\n";
+		break;
+
+	case OP_EXP:
+		Check(Or(Not(Is(in.b, VREAL)), Not(Is(in.c, VREAL))), in.site,
+			"Run-Time Error-Exponentiation requires float operands");
+		body << "\t" << WriteV(in.a, "Exp(" + ReadV(in.b) + ", " + ReadV(in.c) + ")") << "\n";
+		break;
+
+	case OP_AND:
+	case OP_OR:
+		Check(Not(Is(in.b, VBOOL)), in.site, "Run-Time Error-Left operand of logical operation must be boolean");
+		if( Is(in.b, VBOOL) == "false" )
+			break;
+		//fall through
+	case OP_ANDB:
+	case OP_ORB: {
+		bool orOp = in.op == OP_OR || in.op == OP_ORB;
+		body << "\t" << Write(in.a, VBOOL, Read(in.b, VBOOL)) << "\n";
+		body << "\tif( " << (orOp ? "" : "!") << Read(in.a, VBOOL) << " )\n\t\t" << Jump(in.c) << "\n";
+		break;
+	}
+
+	case OP_TESTBOOL:
+		Check(Not(Is(in.a, VBOOL)), in.site, "Run-Time Error-Right operand of logical operation must be boolean");
+		break;
+
+	case OP_PRINT:
+		body << "\t" << Print(in.a) << (in.b ? "\n\tcout << endl;\n" : "\n");
+		break;
+
+	case OP_GET: {
+		ValType type = TypeOf(site->type);
+		if( type == VERR ) {
+			Check("true", in.site, "Invalid type for GET operation");
+			break;
+		}
+		if( Kept(in.a) == type ) {
+			body << "\tif( !Get(" << site->line << ", " << Name(in.a) << ") )\n\t\t" << Unwind(in.site) << "\n";
+			if( checked[in.a] )
+				body << "\tset" << in.a << " = true;\n";
+			break;
+		}
+		body << "\t{\n\t\t" << TypeName(type) << " in;\n";
+		body << "\t\tif( !Get(" << site->line << ", in) )\n\t\t\t" << Unwind(in.site) << "\n";
+		body << "\t\t" << WriteV(in.a, "V(in)") << "\n\t}\n";
+		break;
+	}
+
+	case OP_ASSIGN: {
+		ValType type = TypeOf(site->type);
+		Check(Not(Is(in.b, type)), in.site, "Type mismatch in assignment");
+		if( Is(in.b, type) != "false" )
+			body << "\t" << Store(in.a, in.b, in.c) << "\n";
+		break;
+	}
+
+	case OP_INIT:
+		Check(Not(Is(in.a, TypeOf(site->type))), in.site, "Type mismatch in initialization");
+		break;
+
+	case OP_REDEFINED:
+		Check("true", in.site, "Variable redefinition: " + string(code.names[site->sym]));
+		break;
+
+	case OP_COND:
+		Check(Not(Is(in.a, VBOOL)), in.site, site->sym == 0 ? "Run-Time Error-IF condition must be boolean"
+								: "Run-Time Error-ELSIF condition must be boolean");
+		if( Is(in.a, VBOOL) == "false" )
+			break;
+		//fall through
+	case OP_CONDB:
+		body << "\tif( !" << Read(in.a, VBOOL) << " )\n\t\t" << Jump(in.c) << "\n";
+		break;
+
+	case OP_JUMP:
+		body << "\t" << Jump(in.c) << "\n";
+		break;
+
+	case OP_FAIL:
+		for( const SyntaxMsg& e : code.failures[in.a] )
+			body << "\tError(" << e.line << ", " << Quote(e.msg) << ");\n";
+		body << "\t" << Unwind(in.site) << "\n";
+		break;
+
+	case OP_HALT:
+		body << "\tif( errors == 0 )\n\t\tcout << endl << \"(DONE)\" << endl;\n\treturn true;\n";
+		break;
+
+	case OP_ADDI: case OP_SUBI: case OP_MULI:
+		body << "\t" << Write(in.a, VINT, binary(integer[in.op - OP_ADDI], VINT)) << "\n";
+		break;
+
+	case OP_DIVI:
+	case OP_MODI:
+		Check(Zero(in.c, VINT), in.site, in.op == OP_DIVI ? "Run-Time Error-Illegal division by zero"
+								: "Run-Time Error-Illegal mod by zero");
+		if( Zero(in.c, VINT) == "true" )
+			break;
+		body << "\t" << Write(in.a, VINT, binary(integer[in.op - OP_ADDI], VINT)) << "\n";
+		break;
+
+	case OP_ADDR: case OP_SUBR: case OP_MULR:
+		body << "\t" << Write(in.a, VREAL, binary(arith[in.op - OP_ADDR], VREAL)) << "\n";
+		break;
+
+	case OP_DIVR:
+		Check(Zero(in.c, VREAL), in.site, "Run-Time Error-Illegal division by zero");
+		if( Zero(in.c, VREAL) == "true" )
+			break;
+		body << "\t" << Write(in.a, VREAL, binary(arith[3], VREAL)) << "\n";
+		break;
+
+	case OP_EQI: case OP_NEQI: case OP_LTHANI: case OP_LTEI: case OP_GTHANI: case OP_GTEI:
+		body << "\t" << Write(in.a, VBOOL, binary(relation[in.op - OP_EQI], VINT)) << "\n";
+		break;
+
+	case OP_EQR: case OP_NEQR: case OP_LTHANR: case OP_LTER: case OP_GTHANR: case OP_GTER:
+		body << "\t" << Write(in.a, VBOOL, binary(relation[in.op - OP_EQR], VREAL)) << "\n";
+		break;
+
+	case OP_EQS: case OP_NEQS:
+		body << "\t" << Write(in.a, VBOOL, binary(relation[in.op - OP_EQS], VSTRING)) << "\n";
+		break;
+
+	case OP_CONCATS:
+		body << "\t" << Write(in.a, VSTRING, binary(arith[0], VSTRING)) << "\n";
+		break;
+
+	case OP_NOTB:
+		body << "\t" << Write(in.a, VBOOL, "!" + Read(in.b, VBOOL)) << "\n";
+		break;
+
+	default:
+		break;
+	}
+}
+
+void Emitter::Program(const string& name, ostream& out)
+{
+	for( const Instr& in : code.code )
+		if( in.op == OP_CHECK && IsVar(in.a) )
+			checked[in.a] = true;
+	for( size_t at = 0; at < code.code.size(); at++ ) {
+		//a label is written before the instruction jumped to, so jumps
+		//backwards would need a second pass; the compiler only jumps forwards
+		if( target[at] )
+			body << "L" << at << ":\n";
+		Instruction(code.code[at]);
+	}
+	if( target[code.code.size()] )
+		body << "L" << code.code.size() << ":\n\treturn false;\n";
+
+	string source;
+	for( char ch : name )
+		source += ch == '*' ? '_' : ch;
+	out << "/*\n * " << source << ", translated from SADAL by prog3 --emit-cpp\n"
+		<< " * It prints what prog3 " << source << " prints.\n */\n";
+	out << Support << "\n";
+
+	out << "static const Link chains[] = {\n";
+	for( const ChainLink& link : code.chains )
+		out << "\t{ " << Quote(link.msg) << ", " << link.next << " },\n";
+	out << "\t{ nullptr, -1 }\n};\n\n";
+	out << "//report the chain from at, after the error a phrase failed with\n"
+		<< "static bool Fail(int at)\n{\n"
+		<< "\tfor( ; at >= 0; at = chains[at].next )\n\t\tError(errLine, chains[at].msg);\n"
+		<< "\treturn false;\n}\n\n";
+
+	for( size_t k = 0; k < code.consts.size(); k++ ) {
+		int r = code.ConstBase() + k;
+		//the others are written out where they are used
+		if( !used[r] )
+			continue;
+		const Value& v = code.consts[k];
+		out << "static const V " << Name(r) << "(" << (v.IsString()
+			? "string(" + Quote(v.RawString()) + ", " + to_string(v.RawString().length()) + ")"
+			: Literal(v)) << ");\n";
+	}
+
+	out << "\n//the procedure\nstatic bool Run()\n{\n";
+	for( int r = 0; r < code.ConstBase(); r++ ) {
+		if( !used[r] )
+			continue;
+		if( Kept(r) == VERR )
+			out << "\tV " << Name(r) << ";\n";
+		else
+			out << "\t" << TypeName(Kept(r)) << " " << Name(r) << (Kept(r) == VSTRING ? "" : " = " + string(
+				Kept(r) == VREAL ? "0.0" : Kept(r) == VBOOL ? "false" : Kept(r) == VCHAR ? "char(0)" : "0")) << ";\n";
+		if( IsVar(r) && checked[r] && Kept(r) != VERR )
+			out << "\tbool set" << r << " = false;\n";
+		//a variable only ever assigned
+		if( !read[r] )
+			out << "\t(void) " << Name(r) << ";\n";
+	}
+	out << "\n" << body.str() << "}\n" << Main;
+}
+
+}
+
+void EmitCpp(const Code& code, const string& name, ostream& out)
+{
+	Emitter(code).Program(name, out);
+}
@@ -0,0 +1,192 @@
+/* Execution engine comparison
+ * Execute (walking the syntax tree) against Compile + Run (register bytecode)
+ * and the bytecode compiled on to machine code, on one parsed program. All
+ * must print the same; the output is captured and compared, not shown. -gen writes a synthetic straight-line SADAL
+ * program of arithmetic, comparisons, concatenations and IF statements and
+ * then benchmarks it like any other file.
+ * engineBench_prog.cpp
+ *
+ * CS280 - Spring 2025
+ *
+ * build: g++ -O2 -std=c++17 -I../include engineBench_prog.cpp parserInterp.cpp exec.cpp runtime.cpp compile.cpp vm.cpp jit.cpp ast.cpp fold.cpp arena.cpp val.cpp lex.cpp lexscan.cpp intern.cpp srcfile.cpp tokbuf.cpp lexstream.cpp -o enginebench -lpthread
+ *        (add -DVM_SWITCH for the switch dispatch loop)
+ * usage: enginebench <file> [repetitions]
+ *        enginebench -gen <statements> <file> [repetitions]
+ * The program must not read input: every run would read on from the last.
+ */
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+
+#include "parserInterp.h"
+#include "bytecode.h"
+#include "jit.h"
+#include "srcfile.h"
+
+using namespace std;
+using namespace std::chrono;
+
+//one run of the program with its output captured
+struct Result {
+	bool	status;
+	int	errors;
+	string	output;
+	double	secs;
+};
+
+template <class F>
+static Result Timed(F run)
+{
+	ostringstream out;
+	streambuf* saved = cout.rdbuf(out.rdbuf());
+	auto t0 = steady_clock::now();
+	bool status = run();
+	double secs = duration<double>(steady_clock::now() - t0).count();
+	cout.rdbuf(saved);
+	return Result{ status, ErrCount(), out.str(), secs };
+}
+
+//Synthetic SADAL source: every statement runs once, none fails, and the
+//values stay small, so any run time is the engine's
+static string Synthesize(long statements)
+{
+	srand(280);
+	string prog = "procedure enginebench is\n"
+		"\ti, j, k : integer := 7;\n"
+		"\tx, y : float := 1.5;\n"
+		"\ts, t : string := \"abcdef\";\n"
+		"\tb, c : boolean := true;\n"
+		"begin\n";
+
+	static const char* ints[] = { "i", "j", "k" };
+	static const char* reals[] = { "x", "y" };
+	for( long n = 0; n < statements; n++ ) {
+		string a = ints[rand() % 3], b = ints[rand() % 3];
+		string x = reals[rand() % 2], y = reals[rand() % 2];
+		switch( rand() % 8 ) {
+		case 0: case 1:
+			prog += "\t" + a + " := (" + b + " * " + to_string(rand() % 9 + 2) + " + " + a
+				+ ") mod " + to_string(rand() % 900 + 100) + ";\n";
+			break;
+		case 2:
+			prog += "\t" + x + " := " + y + " * 0.5 + " + x + " / 4.0 + 1.25;\n";
+			break;
+		case 3:
+			prog += "\ts := t(0..3) & s(" + to_string(rand() % 4) + ") & \"xy\";\n"
+				"\tt := s;\n";
+			break;
+		case 4:
+			prog += "\tb := " + a + " < " + b + " and not c or " + x + " >= " + y + ";\n"
+				"\tc := " + a + " = " + b + " or b;\n";
+			break;
+		case 5:
+			prog += "\tif " + a + " > " + b + " then\n"
+				"\t\t" + a + " := " + a + " - " + b + ";\n"
+				"\telsif b then\n"
+				"\t\t" + b + " := " + b + " + 1;\n"
+				"\telse\n"
+				"\t\t" + x + " := " + x + " + 1.0;\n"
+				"\tend if;\n";
+			break;
+		case 6:
+			prog += "\t" + a + " := " + a + " + " + b + " * 2 - " + b + " mod 7;\n";
+			break;
+		default:
+			if( rand() % 8 == 0 )
+				prog += "\tputline(s & \" \" & t(1..2));\n";
+			else
+				prog += "\tk := k mod 1000 + i mod 10;\n";
+			break;
+		}
+	}
+	return prog + "end enginebench;\n";
+}
+
+int main(int argc, char *argv[])
+{
+	if( argc < 2 ) {
+		cerr << "usage: " << argv[0] << " <file> [repetitions]" << endl;
+		cerr << "       " << argv[0] << " -gen <statements> <file> [repetitions]" << endl;
+		return 1;
+	}
+
+	int arg = 1;
+	if( string(argv[1]) == "-gen" ) {
+		if( argc < 4 ) {
+			cerr << "usage: " << argv[0] << " -gen <statements> <file> [repetitions]" << endl;
+			return 1;
+		}
+		ofstream out(argv[3]);
+		out << Synthesize(atol(argv[2]));
+		if( !out ) {
+			cerr << "CANNOT WRITE " << argv[3] << endl;
+			return 1;
+		}
+		arg = 3;
+	}
+
+	string name = argv[arg];
+	int reps = argc > arg + 1 ? atoi(argv[arg + 1]) : 5;
+
+	SourceFile src;
+	if( !src.Open(name) ) {
+		cerr << "CANNOT OPEN " << name << endl;
+		return 1;
+	}
+	Interner names;
+	TokenBuffer toks;
+	LexBuffer buf(src.Data(), src.Size(), &names);
+	int line = 1;
+	toks.Lex(buf, line);
+	LexSource in(toks);
+	line = 1;
+	Program program;
+	Parse(in, line, program);
+
+	auto t0 = steady_clock::now();
+	Code code;
+	Compile(program, code);
+	double compileSecs = duration<double>(steady_clock::now() - t0).count();
+	t0 = steady_clock::now();
+	NativeCode native;
+	bool jit = native.Compile(code);
+	double jitSecs = duration<double>(steady_clock::now() - t0).count();
+
+	double bestTree = 1e30, bestVM = 1e30, bestJit = 1e30;
+	for( int r = 0; r < reps; r++ ) {
+		Result tree = Timed([&] { return Execute(program); });
+		Result vm = Timed([&] { return Run(code); });
+		Result mc = jit ? Timed([&] { Runtime rt(cin, cout, cerr); return native.Run(rt); }) : vm;
+		if( tree.status != vm.status || tree.errors != vm.errors || tree.output != vm.output ||
+		    mc.status != vm.status || mc.errors != vm.errors || mc.output != vm.output ) {
+			cerr << "the engines disagree on " << name << endl;
+			return 1;
+		}
+		bestTree = min(bestTree, tree.secs);
+		bestVM = min(bestVM, vm.secs);
+		bestJit = min(bestJit, mc.secs);
+	}
+
+	cout << name << ": " << src.Size() << " bytes, " << code.code.size() << " instructions, "
+		<< code.Registers() << " registers, best of " << reps << ", " << DispatchKind() << " dispatch" << endl;
+	cout << "tree walk: " << fixed << setprecision(3) << bestTree * 1e3 << " ms" << endl;
+	cout << "bytecode : " << bestVM * 1e3 << " ms, "
+		<< setprecision(1) << bestVM * 1e9 / code.code.size() << " ns/instruction, "
+		<< setprecision(3) << "compiled in " << compileSecs * 1e3 << " ms" << endl;
+	if( jit )
+		cout << "machine code (" << JitKind() << "): " << setprecision(3) << bestJit * 1e3 << " ms, "
+			<< setprecision(1) << bestJit * 1e9 / code.code.size() << " ns/instruction, "
+			<< setprecision(3) << "compiled in " << jitSecs * 1e3 << " ms" << endl;
+	else
+		cout << "machine code: no JIT in this build" << endl;
+	cout << "speedup: " << setprecision(2) << bestTree / bestVM << "x";
+	if( jit )
+		cout << ", " << bestTree / bestJit << "x with machine code";
+	cout << endl;
+	return 0;
+}
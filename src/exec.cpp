@@ -0,0 +1,479 @@
+/*
+ * exec.cpp
+ * Evaluator for the syntax tree of a SADAL program
+ * CS280 - Spring 2025
+ *
+ * Run-time checks are made in the order the one-pass interpreter made them
+ * and report the same messages at the same lines. When one fails, every rule
+ * it was nested in adds its own message on the way out, as the parser's
+ * functions used to on returning false.
+ */
+
+#include "parserInterp.h"
+#include "runtime.h"
+
+// One run of the tree
+struct ExecState {
+    Runtime& rt;
+    const Program& prog;
+    // variable values, indexed by frame slot (VERR: not assigned)
+    vector<Value> vars;
+
+    ExecState(Runtime& rt, const Program& prog) : rt(rt), prog(prog), vars(prog.Frame()) {}
+};
+
+// report a syntax error execution has reached
+static void RunErrors(ExecState& st, const Span<SyntaxMsg>& errors)
+{
+	for( const SyntaxMsg& e : errors )
+		RunError(st.rt, e.line, e.msg);
+}
+
+static bool IsAssigned(ExecState& st, int slot) {
+    return !st.vars[slot].IsErr();
+}
+
+static void SetVar(ExecState& st, int slot, const Value & val) {
+    st.vars[slot] = val;
+}
+
+
+static bool Eval(ExecState& st, const ExprNode* e, Value& retVal);
+
+// Evaluate e, found where the grammar wanted a phrase of level want, and on
+// failure add the messages of the rules between, then msg. An operand of the
+// rule's own level is the left side of a chain of the same operator level,
+// part of the same rule, which has nothing more to say.
+static bool Operand(ExecState& st, const ExprNode* e, int want, const char* msg, Value& retVal) {
+    if (Eval(st, e, retVal)) {
+        return true;
+    }
+    int level = Level(e);
+    if (level < want) {
+        return false;
+    }
+    for (int l = level - 1; l >= want; l--) {
+        if (PassMessage((ExprLevel) l) != NULL) {
+            RunError(st.rt, st.rt.errLine, PassMessage((ExprLevel) l));
+        }
+    }
+    if (msg != NULL) {
+        RunError(st.rt, st.rt.errLine, msg);
+    }
+    return false;
+}
+
+// AND, OR; the right operand is only evaluated when it decides the result
+static bool Logical(ExecState& st, const ExprNode* e, Value& retVal) {
+    Value leftVal;
+    if (!Operand(st, e->left, L_RELATION, NULL, leftVal)) {
+        return false;
+    }
+    if (!leftVal.IsBool()) {
+        RunError(st.rt, e->line2, "Run-Time Error-Left operand of logical operation must be boolean");
+        return false;
+    }
+    if (leftVal.GetBool() == (e->op == OR)) {
+        retVal = leftVal;
+        return true;
+    }
+
+    Value rightVal;
+    if (!Operand(st, e->right, L_RELATION, "Missing expression after logical operator", rightVal)) {
+        return false;
+    }
+    if (!rightVal.IsBool()) {
+        RunError(st.rt, e->line, "Run-Time Error-Right operand of logical operation must be boolean");
+        return false;
+    }
+
+    try {
+        if (e->op == AND) {
+            retVal = leftVal && rightVal;
+        } else {
+            retVal = leftVal || rightVal;
+        }
+    } catch (...) {
+        RunError(st.rt, e->line, "Run-Time Error-Illegal logical operation");
+        return false;
+    }
+    return true;
+}
+
+static bool Relational(ExecState& st, const ExprNode* e, Value& retVal) {
+    Value leftVal, rightVal;
+    if (!Operand(st, e->left, L_SIMPLE, NULL, leftVal)) {
+        return false;
+    }
+    if (!Operand(st, e->right, L_SIMPLE, "Missing expression after relational operator", rightVal)) {
+        return false;
+    }
+
+    try {
+        switch (e->op) {
+            case EQ:    retVal = leftVal == rightVal; break;
+            case NEQ:   retVal = leftVal != rightVal; break;
+            case LTHAN: retVal = leftVal < rightVal; break;
+            case LTE:   retVal = leftVal <= rightVal; break;
+            case GTHAN: retVal = leftVal > rightVal; break;
+            case GTE:   retVal = leftVal >= rightVal; break;
+            default:
+                RunError(st.rt, e->line, "Invalid relational operator");
+                return false;
+        }
+    } catch (...) {
+        RunError(st.rt, e->line, "Run-Time Error-Illegal operand types for comparison");
+        return false;
+    }
+    return true;
+}
+
+// + - &
+static bool Additive(ExecState& st, const ExprNode* e, Value& retVal) {
+    Value leftVal, rightVal;
+    if (!Operand(st, e->left, L_STERM, "Missing operand", leftVal)) {
+        return false;
+    }
+    if (!Operand(st, e->right, L_STERM, "Missing operand after operator", rightVal)) {
+        return false;
+    }
+
+    try {
+        if (e->op == PLUS) {
+            retVal = leftVal + rightVal;
+        }
+        else if (e->op == MINUS) {
+            retVal = leftVal - rightVal;
+        }
+        else {
+            retVal = leftVal.Concat(rightVal);
+        }
+    }
+    catch (...) {
+        RunError(st.rt, e->line, "Run-Time Error-Illegal operation");
+        return false;
+    }
+    return true;
+}
+
+// * / MOD
+static bool Multiplicative(ExecState& st, const ExprNode* e, Value& retVal) {
+    Value leftVal, rightVal;
+    if (!Operand(st, e->left, L_FACTOR, NULL, leftVal)) {
+        return false;
+    }
+    if (!Operand(st, e->right, L_FACTOR, "Missing factor after operator", rightVal)) {
+        return false;
+    }
+
+    try {
+        if (e->op == MULT) {
+            retVal = leftVal * rightVal;
+        }
+        else if (e->op == DIV) {
+            // Check for division by zero
+            if ((rightVal.IsInt() && rightVal.GetInt() == 0) ||
+                (rightVal.IsReal() && rightVal.GetReal() == 0.0)) {
+                RunError(st.rt, e->line, "Run-Time Error-Illegal division by zero");
+                return false;
+            }
+            retVal = leftVal / rightVal;
+        }
+        else {
+            // MOD requires integer operands
+            if (!leftVal.IsInt() || !rightVal.IsInt()) {
+                RunError(st.rt, e->line, "Run-Time Error-Illegal operand types for MOD");
+                return false;
+            }
+            // Check for mod by zero
+            if (rightVal.GetInt() == 0) {
+                RunError(st.rt, e->line, "Run-Time Error-Illegal mod by zero");
+                return false;
+            }
+            retVal = leftVal % rightVal;
+        }
+    } catch (...) {
+        RunError(st.rt, e->line, "Run-Time Error-Illegal operation");
+        return false;
+    }
+    return true;
+}
+
+static bool Power(ExecState& st, const ExprNode* e, Value& retVal) {
+    Value baseVal, expVal;
+    if (!Operand(st, e->left, L_PRIMARY, "Missing primary", baseVal)) {
+        return false;
+    }
+    if (!Operand(st, e->right, L_PRIMARY, "Missing exponent after **", expVal)) {
+        return false;
+    }
+
+    // Type checking - both operands must be real for exponentiation
+    if (!baseVal.IsReal() || !expVal.IsReal()) {
+        RunError(st.rt, e->line, "Run-Time Error-Exponentiation requires float operands");
+        return false;
+    }
+
+    try {
+        retVal = baseVal.Exp(expVal);
+    } catch (...) {
+        RunError(st.rt, e->line, "Run-Time Error-Illegal exponentiation operation");
+        return false;
+    }
+    return true;
+}
+
+// Name ( Range )
+static bool Index(ExecState& st, const ExprNode* e, Value& retVal) {
+    if (!Eval(st, e->left, retVal)) {
+        return false;
+    }
+
+    Value startIdx, endIdx;
+    if (!Operand(st, e->right, L_SIMPLE, "Missing start index in range", startIdx)) {
+        return false;
+    }
+    if (!startIdx.IsInt()) {
+        RunError(st.rt, e->line2, "Range indices must be integers");
+        return false;
+    }
+    if (e->hi != NULL) {
+        if (!Operand(st, e->hi, L_SIMPLE, "Missing end index in range", endIdx)) {
+            return false;
+        }
+        if (!endIdx.IsInt()) {
+            RunError(st.rt, e->line, "Range indices must be integers");
+            return false;
+        }
+        if (startIdx.GetInt() > endIdx.GetInt()) {
+            RunError(st.rt, e->line, "Invalid range - start index > end index");
+            return false;
+        }
+    }
+
+    return Substring(st.rt, retVal, startIdx.GetInt(), e->hi != NULL ? &endIdx : NULL, e->line);
+}
+
+
+static bool Eval(ExecState& st, const ExprNode* e, Value& retVal) {
+    switch (e->kind) {
+        case E_CONST:
+            retVal = e->Const();
+            return true;
+
+        case E_VAR:
+            if (!IsAssigned(st, e->slot)) {
+                RunError(st.rt, e->line, "Uninitialized variable: " + string(st.prog.names[e->slot]));
+                return false;
+            }
+            retVal = st.vars[e->slot];
+            return true;
+
+        case E_INDEX:
+            return Index(st, e, retVal);
+
+        case E_PAREN:
+            return Operand(st, e->left, L_EXPR, "Invalid expression in parentheses", retVal);
+
+        case E_SIGN:
+            if (!Operand(st, e->left, L_TERM, "Missing term after unary sign", retVal)) {
+                return false;
+            }
+            // the sign itself was applied to a numeric constant by the parser
+            if (!retVal.IsInt() && !retVal.IsReal()) {
+                RunError(st.rt, e->line, "Run-Time Error-Illegal operand type for sign operation");
+                return false;
+            }
+            return true;
+
+        case E_NOT: {
+            Value primVal;
+            if (!Operand(st, e->left, L_PRIMARY, "Missing primary after NOT", primVal)) {
+                return false;
+            }
+            if (!primVal.IsBool()) {
+                RunError(st.rt, e->line, "Run-Time Error-Illegal operand type for NOT operation");
+                return false;
+            }
+            try {
+                retVal = !primVal;
+            } catch (...) {
+                RunError(st.rt, e->line, "Run-Time Error-Illegal NOT operation");
+                return false;
+            }
+            return true;
+        }
+
+        case E_BINARY:
+            switch (Level(e)) {
+                case L_EXPR:     return Logical(st, e, retVal);
+                case L_RELATION: return Relational(st, e, retVal);
+                case L_SIMPLE:   return Additive(st, e, retVal);
+                case L_TERM:     return Multiplicative(st, e, retVal);
+                default:         return Power(st, e, retVal);
+            }
+    }
+    return false;
+}
+
+static bool ExecList(ExecState& st, const Span<StmtNode*>& list);
+
+
+// The first clause whose condition holds runs, or the ELSE clause
+static bool ExecIf(ExecState& st, const StmtNode* s) {
+    for (size_t i = 0; i < s->clauses.size(); i++) {
+        const IfClause& clause = s->clauses[i];
+        if (!clause.errors.empty()) {
+            RunErrors(st, clause.errors);
+            return false;
+        }
+        if (clause.cond != NULL) {
+            Value condVal;
+            if (!Operand(st, clause.cond, L_EXPR, i == 0 ? "Missing or invalid condition after IF"
+                                                     : "Missing or invalid condition after ELSIF", condVal)) {
+                return false;
+            }
+            if (!condVal.IsBool()) {
+                RunError(st.rt, clause.line, i == 0 ? "Run-Time Error-IF condition must be boolean"
+                                             : "Run-Time Error-ELSIF condition must be boolean");
+                return false;
+            }
+            if (!condVal.GetBool()) {
+                continue;
+            }
+        }
+        return ExecList(st, clause.body);
+    }
+    return true;
+}
+
+static bool ExecStmt(ExecState& st, const StmtNode* s) {
+    switch (s->kind) {
+        case S_PRINT: {
+            Value retVal;
+            if (!Operand(st, s->expr, L_EXPR, "Invalid expression in print statement", retVal)) {
+                return false;
+            }
+            if (s->newline) {
+                st.rt.out << retVal << endl;  // PUTLN adds newline
+            } else {
+                st.rt.out << retVal;         // PUT doesn't add newline
+            }
+            return true;
+        }
+
+        case S_GET: {
+            Value inputVal;
+            if (!ReadInput(st.rt, s->type, s->line, inputVal)) {
+                return false;
+            }
+            SetVar(st, s->slot, inputVal);
+            return true;
+        }
+
+        case S_ASSIGN: {
+            Value rhsVal;
+            if (!Operand(st, s->expr, L_EXPR, "Invalid expression in assignment", rhsVal)) {
+                return false;
+            }
+            if (!OfType(s->type, rhsVal)) {
+                RunError(st.rt, s->line, "Type mismatch in assignment");
+                return false;
+            }
+            SetVar(st, s->slot, rhsVal);
+            return true;
+        }
+
+        case S_IF:
+            return ExecIf(st, s);
+
+        case S_ERROR:
+            RunErrors(st, s->errors);
+            return false;
+    }
+    return false;
+}
+
+static bool ExecList(ExecState& st, const Span<StmtNode*>& list) {
+    for (const StmtNode* s : list) {
+        if (!ExecStmt(st, s)) {
+            RunError(st.rt, st.rt.errLine, "Syntactic error in statement list.");
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool ExecDecl(ExecState& st, const DeclNode* d) {
+    if (!d->errors.empty()) {
+        RunErrors(st, d->errors);
+        return false;
+    }
+
+    Value initVal;
+    if (d->init != NULL) {
+        if (!Operand(st, d->init, L_EXPR, "Invalid initialization expression", initVal)) {
+            return false;
+        }
+        if (!OfType(d->type, initVal)) {
+            RunError(st.rt, d->initLine, "Type mismatch in initialization");
+            return false;
+        }
+    }
+    if (d->redefined >= 0) {
+        RunError(st.rt, d->line, "Variable redefinition: " + string(st.prog.names[d->redefined]));
+        return false;
+    }
+
+    if (d->init != NULL) {
+        for (int slot : d->slots) {
+            SetVar(st, slot, initVal);
+        }
+    }
+    return true;
+}
+
+// 2. ProcBody ::= DeclPart BEGIN StmtList END ProcName ;
+static bool ExecBody(ExecState& st) {
+    const Program& prog = st.prog;
+    for (size_t i = 0; i < prog.decls.size(); i++) {
+        if (!ExecDecl(st, prog.decls[i])) {
+            RunError(st.rt, st.rt.errLine, i == 0 ? "Non-recognizable Declaration Part." : "Invalid declaration.");
+            return false;
+        }
+    }
+    if (!ExecList(st, prog.body)) {
+        return false;
+    }
+    if (!prog.bodyErrors.empty()) {
+        RunErrors(st, prog.bodyErrors);
+        return false;
+    }
+    return true;
+}
+
+bool Execute(const Program& prog, Runtime& rt) {
+    ExecState st(rt, prog);
+
+    if (!prog.headErrors.empty()) {
+        RunErrors(st, prog.headErrors);
+        return false;
+    }
+
+    if (!ExecBody(st)) {
+        RunError(st.rt, st.rt.errLine, "Incorrect Procedure Definition.");
+        RunError(st.rt, st.rt.errLine, "Incorrect Procedure Body");
+        return false;
+    }
+
+    if (rt.errors == 0) {
+        rt.out << endl << "(DONE)" << endl;
+    }
+
+    return true;
+}
+
+bool Execute(const Program& prog) {
+    Runtime rt(cin, cout, cerr);
+    return Execute(prog, rt);
+}
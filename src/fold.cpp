@@ -0,0 +1,225 @@
+/*
+ * fold.cpp
+ * Evaluates the constant parts of a SADAL program's expressions once, after
+ * parsing, instead of on every run
+ * CS280 - Spring 2025
+ *
+ * A constant part is worked out with the same Value operator the evaluator
+ * would use, and only when the evaluator would get a value out of it without
+ * a word: an operation that fails, or that has the Value operator print its
+ * complaint, is left in the tree to do so when execution reaches it. Nothing
+ * folded can fail, so the messages the rules around it would add never come
+ * up and it may as well be a literal.
+ */
+
+#include <climits>
+#include "ast.h"
+
+static bool IsConst(const ExprNode* e)
+{
+	return e->kind == E_CONST;
+}
+
+//make e the literal val
+static void SetConst(Program& prog, ExprNode* e, const Value& val)
+{
+	e->kind = E_CONST;
+	e->vtype = val.GetType();
+	e->left = e->right = e->hi = NULL;
+	switch( val.GetType() ) {
+	case VINT:
+		e->ival = val.GetInt();
+		break;
+	case VREAL:
+		e->rval = val.GetReal();
+		break;
+	case VBOOL:
+		e->bval = val.GetBool();
+		break;
+	case VCHAR:
+		e->cval = val.GetChar();
+		break;
+	default: {
+		string str = val.GetString();
+		e->text = prog.Text(str);
+		e->slen = str.length();
+		break;
+	}
+	}
+}
+
+static bool Numeric(const Value& v)
+{
+	return v.IsInt() || v.IsReal();
+}
+
+static bool IsZero(const Value& v)
+{
+	return (v.IsInt() && v.GetInt() == 0) || (v.IsReal() && v.GetReal() == 0.0);
+}
+
+static bool Textual(const Value& v)
+{
+	return v.IsString() || v.IsChar();
+}
+
+//whether int left op right has no int result, so working it out here would be
+//undefined or trap; it is left to run as it does unfolded
+static bool IntOverflows(Token op, const Value& left, const Value& right)
+{
+	if( !left.IsInt() || !right.IsInt() )
+		return false;
+	int l = left.GetInt(), r = right.GetInt(), out;
+	switch( op ) {
+	case PLUS:
+		return __builtin_add_overflow(l, r, &out);
+	case MINUS:
+		return __builtin_sub_overflow(l, r, &out);
+	case MULT:
+		return __builtin_mul_overflow(l, r, &out);
+	case DIV: case MOD:
+		return l == INT_MIN && r == -1;
+	default:
+		return false;
+	}
+}
+
+//left op right as the evaluator works it out, if that succeeds quietly
+static bool FoldBinary(Token op, const Value& left, const Value& right, Value& result)
+{
+	bool same = left.GetType() == right.GetType();
+	if( IntOverflows(op, left, right) )
+		return false;
+	switch( op ) {
+	case PLUS:
+		if( !same || !Numeric(left) )
+			return false;
+		result = left + right;
+		return true;
+	case MINUS:
+		if( !same || !Numeric(left) )
+			return false;
+		result = left - right;
+		return true;
+	case MULT:
+		if( !same || !Numeric(left) )
+			return false;
+		result = left * right;
+		return true;
+	case DIV:
+		if( !same || !Numeric(left) || IsZero(right) )
+			return false;
+		result = left / right;
+		return true;
+	case MOD:
+		if( !left.IsInt() || !right.IsInt() || IsZero(right) )
+			return false;
+		result = left % right;
+		return true;
+	case EXP:
+		if( !left.IsReal() || !right.IsReal() || (IsZero(left) && right.GetReal() < 0) )
+			return false;
+		result = left.Exp(right);
+		return true;
+	case CONCAT:
+		if( !Textual(left) || !Textual(right) )
+			return false;
+		result = left.Concat(right);
+		return true;
+	case EQ:
+		if( !same )
+			return false;
+		result = left == right;
+		return true;
+	case NEQ:
+		if( !same )
+			return false;
+		result = left != right;
+		return true;
+	case LTHAN: case LTE: case GTHAN: case GTE:
+		if( !same || left.IsBool() )
+			return false;
+		result = op == LTHAN ? left < right : op == LTE ? left <= right
+			: op == GTHAN ? left > right : left >= right;
+		return true;
+	default:
+		return false;
+	}
+}
+
+static void Fold(Program& prog, ExprNode* e)
+{
+	if( e == NULL || IsConst(e) )
+		return;
+	if( e->kind == E_INDEX ) {
+		Fold(prog, e->right);
+		Fold(prog, e->hi);
+		return;
+	}
+	Fold(prog, e->left);
+	if( e->kind != E_BINARY || (e->op != AND && e->op != OR) )
+		Fold(prog, e->right);
+
+	switch( e->kind ) {
+	case E_PAREN:
+		if( IsConst(e->left) )
+			SetConst(prog, e, e->left->Const());
+		break;
+
+	case E_SIGN:
+		//the sign is already in a numeric literal; anything else fails
+		if( IsConst(e->left) && (e->left->vtype == VINT || e->left->vtype == VREAL) )
+			SetConst(prog, e, e->left->Const());
+		break;
+
+	case E_NOT:
+		if( IsConst(e->left) && e->left->vtype == VBOOL )
+			SetConst(prog, e, Value(!e->left->bval));
+		break;
+
+	case E_BINARY:
+		if( e->op == AND || e->op == OR ) {
+			//a constant left operand that decides the result leaves the right
+			//one unevaluated, as it ever was
+			if( !IsConst(e->left) || e->left->vtype != VBOOL ) {
+				Fold(prog, e->right);
+				break;
+			}
+			if( e->left->bval == (e->op == OR) ) {
+				SetConst(prog, e, e->left->Const());
+				break;
+			}
+			Fold(prog, e->right);
+			if( IsConst(e->right) && e->right->vtype == VBOOL )
+				SetConst(prog, e, e->right->Const());
+			break;
+		}
+		if( IsConst(e->left) && IsConst(e->right) ) {
+			Value result;
+			if( FoldBinary(e->op, e->left->Const(), e->right->Const(), result) && !result.IsErr() )
+				SetConst(prog, e, result);
+		}
+		break;
+
+	default:
+		break;
+	}
+}
+
+static void Fold(Program& prog, const Span<StmtNode*>& list)
+{
+	for( StmtNode* s : list ) {
+		Fold(prog, s->expr);
+		for( IfClause& clause : s->clauses ) {
+			Fold(prog, clause.cond);
+			Fold(prog, clause.body);
+		}
+	}
+}
+
+void Fold(Program& prog)
+{
+	for( DeclNode* d : prog.decls )
+		Fold(prog, d->init);
+	Fold(prog, prog.body);
+}
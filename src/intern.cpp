@@ -0,0 +1,71 @@
+/*
+ * intern.cpp
+ * Identifier interning for the SADAL lexer and parser
+ * CS280 - Spring 2025
+ */
+
+#include <cctype>
+
+#include "intern.h"
+
+static unsigned FoldHash(const char* s, size_t len)
+{
+	unsigned h = 0x811c9dc5u;
+	for( size_t i = 0; i < len; i++ )
+		h = (h ^ (unsigned char) tolower((unsigned char) s[i])) * 0x01000193u;
+	return h;
+}
+
+static bool FoldEqual(const string& name, const char* s, size_t len)
+{
+	if( name.length() != len )
+		return false;
+	for( size_t i = 0; i < len; i++ ) {
+		if( name[i] != tolower((unsigned char) s[i]) )
+			return false;
+	}
+	return true;
+}
+
+int Interner::Intern(const char* s, size_t len)
+{
+	unsigned h = FoldHash(s, len);
+	size_t mask = slots.size() - 1;
+
+	for( size_t i = h & mask; ; i = (i + 1) & mask ) {
+		int id = slots[i];
+		if( id < 0 ) {
+			id = (int) names.size();
+			names.push_back(string(s, len));
+			string& name = names.back();
+			for( size_t j = 0; j < len; j++ )
+				name[j] = tolower((unsigned char) name[j]);
+			hashes.push_back(h);
+			slots[i] = id;
+			if( names.size() * 2 > slots.size() )
+				Grow();
+			return id;
+		}
+		if( hashes[id] == h && FoldEqual(names[id], s, len) )
+			return id;
+	}
+}
+
+void Interner::Grow()
+{
+	slots.assign(slots.size() * 2, -1);
+	size_t mask = slots.size() - 1;
+	for( int id = 0; id < (int) names.size(); id++ ) {
+		size_t i = hashes[id] & mask;
+		while( slots[i] >= 0 )
+			i = (i + 1) & mask;
+		slots[i] = id;
+	}
+}
+
+void Interner::Clear()
+{
+	names.clear();
+	hashes.clear();
+	slots.assign(slots.size(), -1);
+}
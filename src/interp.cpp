@@ -0,0 +1,39 @@
+/*
+ * interp.cpp
+ * A SADAL interpreter as an object
+ * CS280 - Spring 2025
+ */
+
+#include "interp.h"
+#include "parserInterp.h"
+#include "bytecode.h"
+#include "jit.h"
+#include "runtime.h"
+
+bool Interpreter::Run(const char* text, size_t len, istream& in, ostream& out, ostream& err)
+{
+	//the names of the last program go with it
+	names.Clear();
+
+	//the tokens, and the text of those not in the source, go with the run
+	TokenBuffer toks;
+	LexBuffer buf(text, len, &names);
+	int line = 1;
+	toks.Lex(buf, line);
+	LexSource src(toks);
+	line = 1;
+	Program prog;
+	Parse(src, line, prog);
+
+	Runtime rt(in, out, err);
+	bool status;
+	if( engine != TREE ) {
+		Code code;
+		Compile(prog, code);
+		status = engine == JIT ? RunNative(code, rt) : ::Run(code, rt);
+	}
+	else
+		status = Execute(prog, rt);
+	errors = rt.errors;
+	return status;
+}
@@ -0,0 +1,429 @@
+/*
+ * jit.cpp
+ * Compiles the register bytecode of a SADAL procedure into x86-64 machine code
+ * CS280 - Spring 2025
+ *
+ * One pass over the instructions writes the machine code for each in turn.
+ * While it runs, rbx holds the address of the registers and r12 the Frame
+ * the VM needs, both kept across calls. An instruction on known types works
+ * on the raw fields of the Value registers, where the VM's unchecked
+ * accessors would, and leaves them as the VM would. Anything else is a call
+ * to Step, which returns 0 or 1 to end the run with, or the instruction to go
+ * on with; a check that fails calls Step too, which makes the check again
+ * and reports it. A program runs through its code once, never looping, so
+ * what it runs has to be short: the call is a shared stub's, and what a
+ * failing check does is out of the way at the end, after all the
+ * instructions. Jumps are patched once everything has its address.
+ */
+
+#include <cstring>
+
+#include "jit.h"
+
+#if defined(__x86_64__) && defined(__linux__) && !defined(NO_JIT)
+#define JIT_X86_64 1
+#include <sys/mman.h>
+#endif
+
+//what the machine code passes back to the VM
+struct Frame {
+	const Code*	code;
+	Runtime*	rt;
+	Value*	regs;
+};
+
+//run the instruction at on the VM, for the machine code; an exception can't
+//be thrown back through it
+static int StepFrom(Frame* frame, int at) noexcept
+{
+	return Step(*frame->code, *frame->rt, frame->regs, at);
+}
+
+const char* JitKind()
+{
+#ifdef JIT_X86_64
+	return "x86-64";
+#else
+	return "none";
+#endif
+}
+
+#ifdef JIT_X86_64
+
+namespace {
+
+//general registers by number, and the ones of the condition codes used
+enum { EAX = 0, ECX = 1, EDX = 2 };
+enum { CC_E = 0x4, CC_NE = 0x5, CC_BE = 0x6, CC_P = 0xA,
+	CC_L = 0xC, CC_GE = 0xD, CC_LE = 0xE, CC_G = 0xF, CC_A = 0x7, CC_AE = 0x3, CC_NP = 0xB };
+
+//jump targets besides instructions
+enum { EXIT = -1, STEP = -2, FAIL = -3 };
+
+class Assembler {
+	const Code&	code;
+	Value::Layout	layout;
+	vector<uint8_t>	bytes;
+	vector<size_t>	starts;		//of each instruction
+	vector<pair<size_t, int>>	jumps;	//rel32 to patch, and its target
+	vector<pair<size_t, int>>	failures;	//rel32 to patch, to fail instruction
+
+public:
+	Assembler(const Code& code) : code(code), layout(Value::RawLayout()) {}
+
+	bool Fits() const {
+		return (uint64_t) code.Registers() * sizeof(Value) < (uint64_t) INT32_MAX;
+	}
+	const vector<uint8_t>& Bytes() const { return bytes; }
+	//room for the usual size of the code, so it is not copied as it grows
+	void Reserve() { bytes.reserve(code.code.size() * 16 + 4096); }
+	void Program();
+
+private:
+	void Byte(uint8_t b) { bytes.push_back(b); }
+	void Bytes(initializer_list<uint8_t> list) { bytes.insert(bytes.end(), list); }
+	void Dword(uint32_t d) {
+		for( int i = 0; i < 4; i++ )
+			Byte(d >> (8 * i));
+	}
+	void Qword(uint64_t q) {
+		Dword((uint32_t) q);
+		Dword(q >> 32);
+	}
+
+	//the field at offset of register r
+	int32_t Field(int r, size_t offset) const { return r * sizeof(Value) + offset; }
+	int32_t Type(int r) const { return Field(r, layout.type); }
+	int32_t Int(int r) const { return Field(r, layout.ival); }
+	int32_t Real(int r) const { return Field(r, layout.rval); }
+	int32_t Bool(int r) const { return Field(r, layout.bval); }
+
+	//op with its reg operand, and [rbx + disp] for the other
+	void Mem(initializer_list<uint8_t> op, int reg, int32_t disp) {
+		Bytes(op);
+		Byte(0x80 | reg << 3 | 3);
+		Dword(disp);
+	}
+	//rel32 of a jump to target, to be patched
+	void Target(int target) {
+		jumps.push_back(make_pair(bytes.size(), target));
+		Dword(0);
+	}
+	void Jump(int target) { Byte(0xE9); Target(target); }
+	void JumpIf(int cc, int target) { Bytes({ 0x0F, uint8_t(0x80 | cc) }); Target(target); }
+	//a forward jump over code not yet written, to be landed by Land
+	size_t Skip(int cc) {
+		Bytes({ 0x0F, uint8_t(0x80 | cc) });
+		Dword(0);
+		return bytes.size();
+	}
+	void Land(size_t skip) {
+		uint32_t rel = bytes.size() - skip;
+		memcpy(&bytes[skip - 4], &rel, 4);
+	}
+	void SetCC(int cc, int reg) { Bytes({ 0x0F, uint8_t(0x90 | cc), uint8_t(0xC0 | reg) }); }
+
+	void PutType(int r, ValType type) { Mem({ 0xC7 }, 0, Type(r)); Dword(type); }
+	//r.Itemp = eax, r.Rtemp = xmm0, r.Btemp = al, and its type with it
+	void PutInt(int r) { Mem({ 0x89 }, EAX, Int(r)); PutType(r, VINT); }
+	void PutReal(int r) { Mem({ 0xF2, 0x0F, 0x11 }, 0, Real(r)); PutType(r, VREAL); }
+	void PutBool(int r) { Mem({ 0x88 }, EAX, Bool(r)); PutType(r, VBOOL); }
+	void LoadInt(int reg, int r) { Mem({ 0x8B }, reg, Int(r)); }
+	void LoadReal(int xmm, int r) { Mem({ 0xF2, 0x0F, 0x10 }, xmm, Real(r)); }
+	void LoadBool(int r) { Mem({ 0x0F, 0xB6 }, EAX, Bool(r)); }
+
+	//Step(at) through the stub, which ends the run if that does, and on to
+	//the next instruction, or one it may jump to
+	void Stepped(int at, int jump = -1) {
+		Byte(0xBE);				//mov esi, at
+		Dword(at);
+		Byte(0xE8);				//call STEP
+		Target(STEP);
+		if( jump >= 0 ) {
+			Byte(0x3D);			//cmp eax, 2 + jump
+			Dword(2 + jump);
+			JumpIf(CC_E, jump);
+		}
+	}
+	//the instruction at fails if cc: Step reports it, and ends the run
+	void FailIf(int cc, int at) {
+		Bytes({ 0x0F, uint8_t(0x80 | cc) });
+		failures.push_back(make_pair(bytes.size(), at));
+		Dword(0);
+	}
+	//the instruction at always ends the run, as Step runs it
+	void Ends(int at) {
+		Byte(0xBE);				//mov esi, at
+		Dword(at);
+		Jump(FAIL);
+	}
+	//code after the instructions
+	void Stubs(size_t exit);
+
+	void Instruction(int at);
+};
+
+void Assembler::Instruction(int at)
+{
+	const Instr& in = code.code[at];
+	switch( in.op ) {
+	case OP_MOVE:
+	case OP_TAKE:
+		//a variable of one of these types is given a value of that type
+		switch( in.a < code.vars ? code.types[in.a] : VERR ) {
+		case VINT:	LoadInt(EAX, in.b); PutInt(in.a); return;
+		case VREAL:	LoadReal(0, in.b); PutReal(in.a); return;
+		case VBOOL:	LoadBool(in.b); PutBool(in.a); return;
+		default:	break;
+		}
+		break;
+
+	case OP_CHECK:
+		Mem({ 0x83 }, 7, Type(in.a));		//cmp dword type, VERR
+		Byte(VERR);
+		FailIf(CC_E, at);
+		return;
+
+	case OP_ADDI: case OP_SUBI: case OP_MULI:
+		LoadInt(EAX, in.b);
+		if( in.op == OP_ADDI )
+			Mem({ 0x03 }, EAX, Int(in.c));
+		else if( in.op == OP_SUBI )
+			Mem({ 0x2B }, EAX, Int(in.c));
+		else
+			Mem({ 0x0F, 0xAF }, EAX, Int(in.c));
+		PutInt(in.a);
+		return;
+
+	case OP_DIVI:
+	case OP_MODI: {
+		LoadInt(ECX, in.c);
+		Bytes({ 0x85, 0xC9 });			//test ecx, ecx
+		FailIf(CC_E, at);
+		LoadInt(EAX, in.b);
+		Bytes({ 0x99, 0xF7, 0xF9 });		//cdq; idiv ecx
+		if( in.op == OP_MODI )
+			Bytes({ 0x89, 0xD0 });		//mov eax, edx
+		PutInt(in.a);
+		return;
+	}
+
+	case OP_ADDR: case OP_SUBR: case OP_MULR:
+		LoadReal(0, in.b);
+		Mem({ 0xF2, 0x0F, uint8_t(in.op == OP_ADDR ? 0x58 : in.op == OP_SUBR ? 0x5C : 0x59) }, 0, Real(in.c));
+		PutReal(in.a);
+		return;
+
+	case OP_DIVR: {
+		//the VM fails on == 0.0, which a NaN is not
+		LoadReal(1, in.c);
+		Bytes({ 0x66, 0x0F, 0x57, 0xD2 });	//xorpd xmm2, xmm2
+		Bytes({ 0x66, 0x0F, 0x2E, 0xCA });	//ucomisd xmm1, xmm2
+		size_t nan = Skip(CC_P);
+		FailIf(CC_E, at);
+		Land(nan);
+		LoadReal(0, in.b);
+		Bytes({ 0xF2, 0x0F, 0x5E, 0xC1 });	//divsd xmm0, xmm1
+		PutReal(in.a);
+		return;
+	}
+
+	case OP_EQI: case OP_NEQI: case OP_LTHANI: case OP_LTEI: case OP_GTHANI: case OP_GTEI: {
+		static const int cc[] = { CC_E, CC_NE, CC_L, CC_LE, CC_G, CC_GE };
+		LoadInt(EAX, in.b);
+		Mem({ 0x3B }, EAX, Int(in.c));
+		SetCC(cc[in.op - OP_EQI], EAX);
+		PutBool(in.a);
+		return;
+	}
+
+	case OP_EQR: case OP_NEQR: case OP_LTHANR: case OP_LTER: case OP_GTHANR: case OP_GTER: {
+		//ucomisd leaves a NaN unordered, which is only not equal, as in C++;
+		//b < c is taken as c > b, which is false for a NaN, as b < c is
+		bool swap = in.op == OP_LTHANR || in.op == OP_LTER;
+		LoadReal(0, swap ? in.c : in.b);
+		Mem({ 0x66, 0x0F, 0x2E }, 0, Real(swap ? in.b : in.c));
+		switch( in.op ) {
+		case OP_EQR:
+			SetCC(CC_E, EAX);
+			SetCC(CC_NP, ECX);
+			Bytes({ 0x20, 0xC8 });		//and al, cl
+			break;
+		case OP_NEQR:
+			SetCC(CC_NE, EAX);
+			SetCC(CC_P, ECX);
+			Bytes({ 0x08, 0xC8 });		//or al, cl
+			break;
+		case OP_LTHANR: case OP_GTHANR:
+			SetCC(CC_A, EAX);
+			break;
+		default:
+			SetCC(CC_AE, EAX);
+			break;
+		}
+		PutBool(in.a);
+		return;
+	}
+
+	case OP_NOTB:
+		LoadBool(in.b);
+		Bytes({ 0x83, 0xF0, 0x01 });		//xor eax, 1
+		PutBool(in.a);
+		return;
+
+	case OP_ANDB:
+	case OP_ORB:
+		LoadBool(in.b);
+		PutBool(in.a);
+		Bytes({ 0x84, 0xC0 });			//test al, al
+		JumpIf(in.op == OP_ORB ? CC_NE : CC_E, in.c);
+		return;
+
+	case OP_CONDB:
+		Mem({ 0x80 }, 7, Bool(in.a));		//cmp byte, 0
+		Byte(0);
+		JumpIf(CC_E, in.c);
+		return;
+
+	case OP_JUMP:
+		Jump(in.c);
+		return;
+
+	case OP_AND: case OP_OR: case OP_COND:
+		Stepped(at, in.c);
+		return;
+
+	case OP_REDEFINED: case OP_FAIL: case OP_HALT:
+		Ends(at);
+		return;
+
+	default:
+		break;
+	}
+	Stepped(at);
+}
+
+void Assembler::Program()
+{
+	Bytes({ 0x53, 0x41, 0x54, 0x41, 0x55 });	//push rbx; push r12; push r13
+	Bytes({ 0x48, 0x89, 0xFB });			//mov rbx, rdi
+	Bytes({ 0x49, 0x89, 0xF4 });			//mov r12, rsi
+	for( size_t at = 0; at < code.code.size(); at++ ) {
+		starts.push_back(bytes.size());
+		Instruction(at);
+	}
+	//running off the end, which compiled code never does, fails
+	starts.push_back(bytes.size());
+	Bytes({ 0x31, 0xC0 });				//xor eax, eax
+	size_t exit = bytes.size();
+	Bytes({ 0x41, 0x5D, 0x41, 0x5C, 0x5B, 0xC3 });	//pop r13; pop r12; pop rbx; ret
+	Stubs(exit);
+}
+
+void Assembler::Stubs(size_t exit)
+{
+	//STEP: called with the instruction in esi; returns to the caller to go
+	//on, or leaves by the epilogue with what Step returned
+	size_t step = bytes.size();
+	Bytes({ 0x4C, 0x89, 0xE7 });			//mov rdi, r12
+	Bytes({ 0x48, 0x83, 0xEC, 0x08 });		//sub rsp, 8, for the call
+	Bytes({ 0x48, 0xB8 });				//mov rax, StepFrom
+	Qword((uint64_t) &StepFrom);
+	Bytes({ 0xFF, 0xD0 });				//call rax
+	Bytes({ 0x48, 0x83, 0xC4, 0x08 });		//add rsp, 8
+	Bytes({ 0x83, 0xF8, 0x01 });			//cmp eax, 1
+	Bytes({ 0x76, 0x01, 0xC3 });			//jbe over ret; ret
+	Bytes({ 0x48, 0x83, 0xC4, 0x08 });		//add rsp, 8: the return address
+	Jump(EXIT);
+
+	//FAIL: jumped to with the instruction in esi, to run it and end there
+	size_t fail = bytes.size();
+	Bytes({ 0x4C, 0x89, 0xE7 });			//mov rdi, r12
+	Bytes({ 0x48, 0xB8 });				//mov rax, StepFrom
+	Qword((uint64_t) &StepFrom);
+	Bytes({ 0xFF, 0xD0 });				//call rax
+	Jump(EXIT);
+
+	//a check that fails goes here to load its instruction for FAIL
+	for( const auto& failure : failures ) {
+		uint32_t rel = bytes.size() - (failure.first + 4);
+		memcpy(&bytes[failure.first], &rel, 4);
+		Ends(failure.second);
+	}
+
+	for( const auto& jump : jumps ) {
+		size_t to = jump.second == EXIT ? exit : jump.second == STEP ? step : jump.second == FAIL ? fail
+			: starts[min<size_t>(jump.second, code.code.size())];
+		uint32_t rel = to - (jump.first + 4);
+		memcpy(&bytes[jump.first], &rel, 4);
+	}
+}
+
+}
+
+#endif
+
+NativeCode::~NativeCode()
+{
+#ifdef JIT_X86_64
+	if( mem != NULL )
+		munmap(mem, size);
+#endif
+}
+
+bool NativeCode::Compile(const Code& compiled)
+{
+#ifdef JIT_X86_64
+	static_assert(sizeof(ValType) == 4 && sizeof(bool) == 1, "the machine code's idea of a Value");
+	Assembler as(compiled);
+	if( !as.Fits() )
+		return false;
+	as.Reserve();
+	as.Program();
+
+	//written while writable, then only executable
+	size_t bytes = as.Bytes().size();
+	void* at = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if( at == MAP_FAILED )
+		return false;
+	memcpy(at, as.Bytes().data(), bytes);
+	if( mprotect(at, bytes, PROT_READ | PROT_EXEC) != 0 ) {
+		munmap(at, bytes);
+		return false;
+	}
+	if( mem != NULL )
+		munmap(mem, size);
+	code = &compiled;
+	mem = at;
+	size = bytes;
+	entry = (int (*)(Value*, void*)) at;
+	return true;
+#else
+	(void) compiled;
+	return false;
+#endif
+}
+
+bool NativeCode::Run(Runtime& rt) const
+{
+	if( entry == NULL )
+		return false;
+	vector<Value> regs(code->Registers());
+	copy(code->consts.begin(), code->consts.end(), regs.begin() + code->ConstBase());
+	Frame frame = Frame{ code, &rt, regs.data() };
+	return entry(regs.data(), &frame) == 1;
+}
+
+bool RunNative(const Code& code, Runtime& rt)
+{
+	NativeCode native;
+	if( !native.Compile(code) )
+		return Run(code, rt);
+	return native.Run(rt);
+}
+
+bool RunNative(const Code& code)
+{
+	Runtime rt(cin, cout, cerr);
+	return RunNative(code, rt);
+}
@@ -5,48 +5,191 @@
  */
 
 #include <cctype>
+#include <cstring>
+#include <charconv>
 #include <map>
+#include <memory>
+#include <algorithm>
 
 using std::map;
 using namespace std;
 
 #include "lex.h"
-//Keywords or reserved words mapping
-LexItem id_or_kw(const string& lexeme , int linenum)
+#include "lexscan.h"
+//Keywords or reserved words
+struct Keyword {
+	const char*	name;
+	size_t	len;
+	Token	token;
+};
+
+static constexpr Keyword kwlist[] = {
+	{ "put", 3, PUT }, { "putline", 7, PUTLN }, { "get", 3, GET },
+	{ "if", 2, IF }, { "elsif", 5, ELSIF },
+	{ "else", 4, ELSE },
+	{ "string", 6, STRING },
+	{ "integer", 7, INT },
+	{ "float", 5, FLOAT },
+	{ "character", 9, CHAR },
+	{ "boolean", 7, BOOL },
+	{ "procedure", 9, PROCEDURE }, { "begin", 5, BEGIN },
+	{ "true", 4, TRUE }, { "then", 4, THEN }, { "constant", 8, CONST },
+	{ "false", 5, FALSE }, { "is", 2, IS }, { "end", 3, END },
+	{ "mod", 3, MOD }, { "and", 3, AND }, { "or", 2, OR }, { "not", 3, NOT },
+};
+
+static constexpr int KWCOUNT = sizeof(kwlist) / sizeof(kwlist[0]);
+static constexpr size_t KWMAXLEN = 9;
+static constexpr unsigned KWSLOTS = 64;
+
+//Keyword hash; the seed is picked at compile time so that no two keywords share a slot
+static constexpr unsigned KwHash(const char* s, size_t len, unsigned seed)
 {
-	string strlexeme = lexeme;
-	map<string,Token> kwmap = {
-		{ "put", PUT}, { "putline", PUTLN}, { "get", GET},
-		{ "if", IF }, { "elsif", ELSIF }, 
-		{ "else", ELSE },
-		{ "string", STRING },
-		{ "integer", INT },
-		{ "float", FLOAT },
-		{ "character", CHAR },
-		{ "boolean", BOOL },
-		{ "procedure", PROCEDURE }, { "begin", BEGIN },
-		{ "true", TRUE }, { "then", THEN }, { "constant", CONST },
-		{ "false", FALSE }, { "is", IS }, { "end", END },
-		{ "mod", MOD }, { "and", AND }, { "or", OR }, { "not", NOT },
-		
-	};
-	Token tt ;
-	
-	for(int i = 0; i < lexeme.length(); i++)
-	{
-		strlexeme[i] = tolower(strlexeme[i]);
+	unsigned h = seed ^ (unsigned) len;
+	for( size_t i = 0; i < len; i++ )
+		h = (h ^ (unsigned char) s[i]) * 0x01000193u;
+	return (h ^ (h >> 15)) & (KWSLOTS - 1);
+}
+
+static constexpr bool KwSeedWorks(unsigned seed)
+{
+	bool used[KWSLOTS] = {};
+	for( int i = 0; i < KWCOUNT; i++ ) {
+		unsigned slot = KwHash(kwlist[i].name, kwlist[i].len, seed);
+		if( used[slot] )
+			return false;
+		used[slot] = true;
 	}
-	
-	tt = IDENT;
-	auto kIt = kwmap.find(strlexeme);
-	if( kIt != kwmap.end() )
+	return true;
+}
+
+static constexpr unsigned KwFindSeed()
+{
+	unsigned seed = 0x811c9dc5u;
+	while( !KwSeedWorks(seed) )
+		seed++;
+	return seed;
+}
+
+static constexpr unsigned KWSEED = KwFindSeed();
+
+//slot -> index into kwlist, or -1
+struct KwTable {
+	signed char	slot[KWSLOTS];
+};
+
+static constexpr KwTable KwBuildTable()
+{
+	KwTable t = {};
+	for( unsigned i = 0; i < KWSLOTS; i++ )
+		t.slot[i] = -1;
+	for( int i = 0; i < KWCOUNT; i++ )
+		t.slot[KwHash(kwlist[i].name, kwlist[i].len, KWSEED)] = (signed char) i;
+	return t;
+}
+
+static constexpr KwTable kwtable = KwBuildTable();
+
+static_assert(KWCOUNT < 128, "keyword index must fit in the slot table");
+
+//Keyword token for s[0..len), or IDENT
+static Token KwToken(const char* s, size_t len)
+{
+	if( len < 2 || len > KWMAXLEN )
+		return IDENT;
+
+	char lower[KWMAXLEN];
+	for( size_t i = 0; i < len; i++ )
+		lower[i] = tolower((unsigned char) s[i]);
+
+	int k = kwtable.slot[KwHash(lower, len, KWSEED)];
+	if( k >= 0 && kwlist[k].len == len && memcmp(kwlist[k].name, lower, len) == 0 )
+		return kwlist[k].token;
+	return IDENT;
+}
+
+//Keywords or reserved words mapping
+LexItem id_or_kw(const string& lexeme, int linenum, Interner& names, LexemePool& pool)
+{
+	Token tt = KwToken(lexeme.data(), lexeme.length());
+
+	if( tt == IDENT )
 	{
-		tt = kIt->second;
+		return IdentItem(names.Intern(lexeme), names, linenum);
 	}
-	
 	if(tt == TRUE || tt == FALSE)	
 		tt = BCONST;
-	return LexItem(tt, lexeme, linenum);
+	return LexItem(tt, lexeme, linenum, pool);
+}
+
+static const string IntRange = "Integer constant out of range: ";
+static const string RealRange = "Real constant out of range: ";
+static const string NameRange = "Too many identifiers";
+
+//Check a numeric constant converts to the value stoi or stod gave it. Both
+//take the longest prefix that reads as a number, so an integer is its digits
+//up to any exponent, which is not applied (2E4 is 2), and an exponent marker
+//with no digits after it is left off (1.5E+ is 1.5).
+//The token keeps the text it was written as; one that doesn't fit comes back
+//as an ERR token.
+static LexItem NumberItem(Token tt, const char* s, size_t len, int linenum, LexemePool& pool)
+{
+	const char* end = s + len;
+	auto lexeme = [=]() { return string(s, len); };
+
+	if( tt == FCONST ) {
+		double rval;
+		from_chars_result res = from_chars(s, end, rval);
+		if( res.ec == errc::result_out_of_range )
+			return LexItem(ERR, RealRange + lexeme(), linenum, pool);
+		if( res.ec != errc() )
+			return LexItem(ERR, "Invalid real constant: " + lexeme(), linenum, pool);
+		return LexItem(FCONST, s, len, linenum);
+	}
+
+	int ival;
+	from_chars_result res = from_chars(s, end, ival);
+	if( res.ec == errc::result_out_of_range )
+		return LexItem(ERR, IntRange + lexeme(), linenum, pool);
+	return LexItem(ICONST, s, len, linenum);
+}
+
+//the same for a lexeme read from a stream, whose text goes to the pool
+static LexItem NumberItem(Token tt, const string& lexeme, int linenum, LexemePool& pool)
+{
+	LexItem tok = NumberItem(tt, lexeme.data(), lexeme.length(), linenum, pool);
+	return tok == ERR ? tok : LexItem(tt, lexeme, linenum, pool);
+}
+
+int LexItem::GetIntValue() const
+{
+	int ival = 0;
+	from_chars(text, text + len, ival);
+	return ival;
+}
+
+double LexItem::GetRealValue() const
+{
+	double rval = 0;
+	from_chars(text, text + len, rval);
+	return rval;
+}
+
+bool LexItem::OutOfRange() const
+{
+	if( token != ERR )
+		return false;
+	string_view msg = Text();
+	return msg.substr(0, IntRange.size()) == IntRange ||
+		msg.substr(0, RealRange.size()) == RealRange ||
+		msg == NameRange;
+}
+
+LexItem IdentItem(int sym, const Interner& names, int linenum)
+{
+	if( (size_t) sym > LexItem::MAXLEN )
+		return LexItem(ERR, NameRange.data(), NameRange.size(), linenum);
+	return LexItem(sym, names.Name(sym), linenum);
 }
 
 map<Token,string> tokenPrint = {
@@ -119,7 +262,7 @@ ostream& operator<<(ostream& out, const LexItem& tok) {
 	return out;
 }
 
-LexItem getNextToken(istream& in, int& linenum)
+LexItem getNextToken(istream& in, int& linenum, Interner& names, LexemePool& pool)
 {
 	enum TokState { START, INID, INSTR, ININT, INREAL, INEXP, INCHAR, INCOMMENT } lexstate = START;
 	string lexeme, ErrMsg;
@@ -182,7 +325,7 @@ LexItem getNextToken(istream& in, int& linenum)
 				{
 					tt = MINUS;
 					lexeme = ch;
-					return LexItem(tt, lexeme, linenum);
+					return LexItem(tt, lexeme, linenum, pool);
 					
 				}	
 			}
@@ -266,7 +409,7 @@ LexItem getNextToken(istream& in, int& linenum)
 					break;
 				
 				}//end of inner switch
-				return LexItem(tt, lexeme, linenum);
+				return LexItem(tt, lexeme, linenum, pool);
 			}//end of else
 			
 			break;	//break out of START case
@@ -280,13 +423,13 @@ LexItem getNextToken(istream& in, int& linenum)
 				
 				if(ch == '_' && nextchar == '_')
 				{
-					return id_or_kw(lexeme, linenum);
+					return id_or_kw(lexeme, linenum, names, pool);
 				}
 			}
 			else {
 				in.putback(ch);
 				
-				return id_or_kw(lexeme, linenum);
+				return id_or_kw(lexeme, linenum, names, pool);
 				
 			}
 			break;
@@ -295,20 +438,20 @@ LexItem getNextToken(istream& in, int& linenum)
             
 			if( ch == '\n' ) {
 				ErrMsg = "New line is an invalid character constant.";
-				return LexItem(ERR, ErrMsg, linenum);
+				return LexItem(ERR, ErrMsg, linenum, pool);
 			}
 			else if( ch == '\'' && lexeme.length() == 1) {
 				
-				return LexItem(CCONST, lexeme, linenum);
+				return LexItem(CCONST, lexeme, linenum, pool);
 			}
 			else if(lexeme.length() >= 1)
 			{
 				lexeme += ch;
-				return LexItem(ERR, " Invalid character constant \'" + lexeme + "\'", linenum);
+				return LexItem(ERR, " Invalid character constant \'" + lexeme + "\'", linenum, pool);
 			}
 			else if(ch == '\'' && lexeme.length() == 0)
 			{
-				return LexItem(ERR, " Invalid character constant \'\'", linenum);
+				return LexItem(ERR, " Invalid character constant \'\'", linenum, pool);
 			}
 			lexeme += ch;
 			break;
@@ -316,10 +459,10 @@ LexItem getNextToken(istream& in, int& linenum)
 		case INSTR:
                          
 			if( ch == '\n' ) {
-				return LexItem(ERR, " Invalid string constant \"" + lexeme, linenum);
+				return LexItem(ERR, " Invalid string constant \"" + lexeme, linenum, pool);
 			}
 			if( ch == '\"' ) {
-				return LexItem(SCONST, lexeme, linenum);
+				return LexItem(SCONST, lexeme, linenum, pool);
 			}
 			lexeme += ch;
 			break;
@@ -339,7 +482,7 @@ LexItem getNextToken(istream& in, int& linenum)
 				else
 				{
 					in.putback(ch);
-					return LexItem(ICONST, lexeme, linenum);
+					return NumberItem(ICONST, lexeme, linenum, pool);
 				}
 				
 			}
@@ -357,12 +500,12 @@ LexItem getNextToken(istream& in, int& linenum)
 				else
 				{
 					in.putback(ch);
-					return LexItem(ICONST, lexeme, linenum);
+					return NumberItem(ICONST, lexeme, linenum, pool);
 				}
 			}
 			else {
 				in.putback(ch);
-				return LexItem(ICONST, lexeme, linenum);
+				return NumberItem(ICONST, lexeme, linenum, pool);
 			}
 			break;
 		
@@ -391,19 +534,19 @@ LexItem getNextToken(istream& in, int& linenum)
 				else
 				{
 					in.putback(ch);
-					return LexItem(FCONST, lexeme, linenum);
+					return NumberItem(FCONST, lexeme, linenum, pool);
 				}
 			}
 			
 			else if((ch == '.') && dec && isdigit(in.peek())){
 				lexeme += ch;
 				
-				return LexItem(ERR, lexeme, linenum);
+				return LexItem(ERR, lexeme, linenum, pool);
 			}
 			else {
 				in.putback(ch);
 				
-				return LexItem(FCONST, lexeme, linenum);
+				return NumberItem(FCONST, lexeme, linenum, pool);
 			}
 			
 			break;
@@ -417,11 +560,11 @@ LexItem getNextToken(istream& in, int& linenum)
 				in.putback(ch);
 				if(intexp)
 				{
-					return LexItem(ICONST, lexeme, linenum);
+					return NumberItem(ICONST, lexeme, linenum, pool);
 				}
 				if(floatexp)
 				{
-					return LexItem(FCONST, lexeme, linenum);
+					return NumberItem(FCONST, lexeme, linenum, pool);
 				}
 			}
 								
@@ -437,12 +580,357 @@ LexItem getNextToken(istream& in, int& linenum)
 	}//end of while loop
 	
 	if( in.eof() )
-		return LexItem(DONE, "", linenum);
+		return LexItem(DONE, "", 0, linenum);
 		
-	return LexItem(ERR, "Error: Some strange symbol", linenum);
+	return LexItem(ERR, "Error: Some strange symbol", linenum, pool);
+}
+
+//Names and text of tokens lexed for a caller that keeps no interner or pool
+//of its own (the stand-alone parsers); they last as long as the thread
+static thread_local Interner ThreadNames;
+static thread_local LexemePool ThreadPool;
+
+LexItem getNextToken(istream& in, int& linenum)
+{
+	return getNextToken(in, linenum, ThreadNames, ThreadPool);
+}
+
+LexItem id_or_kw(const string& lexeme, int linenum)
+{
+	return id_or_kw(lexeme, linenum, ThreadNames, ThreadPool);
 }
 
 
 
 
 
+//Tables for getNextToken(LexBuffer&), all built at compile time. Identifiers and
+//numeric constants go through a small automaton over character classes, and
+//operators are looked up by their first (and possibly second) character, so
+//scanning needs no isalpha/isdigit calls and no per-character switch.
+enum CharClass : unsigned char {
+	C_OTHER, C_LETTER, C_ELETTER, C_DIGIT, C_UNDER, C_DOT, C_SIGN, C_COUNT
+};
+
+struct CharClassTable {
+	CharClass	cls[256];
+	constexpr CharClass operator[](unsigned char ch) const { return cls[ch]; }
+};
+
+static constexpr CharClassTable BuildCharClasses()
+{
+	CharClassTable t = {};
+	for( int ch = 'a'; ch <= 'z'; ch++ ) {
+		t.cls[ch] = C_LETTER;
+		t.cls[ch - 'a' + 'A'] = C_LETTER;
+	}
+	t.cls['e'] = t.cls['E'] = C_ELETTER;
+	for( int ch = '0'; ch <= '9'; ch++ )
+		t.cls[ch] = C_DIGIT;
+	t.cls['_'] = C_UNDER;
+	t.cls['.'] = C_DOT;
+	t.cls['+'] = t.cls['-'] = C_SIGN;
+	return t;
+}
+
+static constexpr CharClassTable charClass = BuildCharClasses();
+
+//States after the first character. The _DOT and _E states have only looked
+//ahead: if the next character doesn't continue the constant, the scan backs
+//up one character to the state in back[]. An underscore may not be doubled,
+//and "1.2." before a digit is an error.
+enum DfaState : unsigned char {
+	D_STOP, D_ID, D_IDUNDER, D_INT, D_INTDOT, D_INTE, D_INTEXP,
+	D_FRAC, D_FRACDOT, D_FRACE, D_FRACEXP, D_DOTERR, D_COUNT
+};
+
+struct DfaTables {
+	DfaState	next[D_COUNT][C_COUNT];
+	DfaState	back[D_COUNT];
+	Token	token[D_COUNT];
+};
+
+static constexpr DfaTables BuildDfa()
+{
+	DfaTables t = {};
+	for( int s = 0; s < D_COUNT; s++ ) {
+		t.back[s] = (DfaState) s;
+		t.token[s] = ERR;
+	}
+
+	for( DfaState s : { D_ID, D_IDUNDER } ) {
+		t.next[s][C_LETTER] = t.next[s][C_ELETTER] = t.next[s][C_DIGIT] = D_ID;
+		t.token[s] = IDENT;
+	}
+	t.next[D_ID][C_UNDER] = D_IDUNDER;
+
+	t.next[D_INT][C_DIGIT] = D_INT;
+	t.next[D_INT][C_DOT] = D_INTDOT;
+	t.next[D_INT][C_ELETTER] = D_INTE;
+	t.next[D_INTDOT][C_DIGIT] = D_FRAC;
+	t.next[D_INTE][C_SIGN] = t.next[D_INTE][C_DIGIT] = D_INTEXP;
+	t.next[D_INTEXP][C_DIGIT] = D_INTEXP;
+	t.back[D_INTDOT] = t.back[D_INTE] = D_INT;
+	t.token[D_INT] = t.token[D_INTEXP] = ICONST;
+
+	t.next[D_FRAC][C_DIGIT] = D_FRAC;
+	t.next[D_FRAC][C_DOT] = D_FRACDOT;
+	t.next[D_FRAC][C_ELETTER] = D_FRACE;
+	t.next[D_FRACDOT][C_DIGIT] = D_DOTERR;
+	t.next[D_FRACE][C_SIGN] = t.next[D_FRACE][C_DIGIT] = D_FRACEXP;
+	t.next[D_FRACEXP][C_DIGIT] = D_FRACEXP;
+	t.back[D_FRACDOT] = t.back[D_FRACE] = D_FRAC;
+	t.token[D_FRAC] = t.token[D_FRACEXP] = FCONST;
+	return t;
+}
+
+static constexpr DfaTables dfa = BuildDfa();
+
+//Operators and delimiters with their spellings
+struct Operator {
+	const char*	spelling;
+	Token	token;
+};
+
+static constexpr Operator oplist[] = {
+	{ "+", PLUS }, { "-", MINUS }, { "*", MULT }, { "/", DIV },
+	{ "=", EQ }, { ">", GTHAN }, { "<", LTHAN }, { ":", COLON },
+	{ "(", LPAREN }, { ")", RPAREN }, { ",", COMMA }, { ";", SEMICOL },
+	{ "&", CONCAT }, { ".", DOT },
+	{ "**", EXP }, { ">=", GTE }, { "<=", LTE }, { ":=", ASSOP }, { "/=", NEQ },
+};
+
+//Operator tokens by first character (ERR if none), and the two-character
+//operators by their first character: the second character and the token
+struct OpTables {
+	Token	single[256];
+	char	second[256];
+	Token	pair[256];
+};
+
+static constexpr OpTables BuildOps()
+{
+	OpTables t = {};
+	for( int ch = 0; ch < 256; ch++ )
+		t.single[ch] = t.pair[ch] = ERR;
+	for( const Operator& op : oplist ) {
+		unsigned char first = op.spelling[0];
+		if( op.spelling[1] == 0 )
+			t.single[first] = op.token;
+		else {
+			t.second[first] = op.spelling[1];
+			t.pair[first] = op.token;
+		}
+	}
+	return t;
+}
+
+static constexpr OpTables ops = BuildOps();
+
+//The fixed text of keywords, operators and DONE, by token (NULL for the rest).
+//Tokens with such a text point here instead of at a copy.
+struct SpellingTable {
+	const char*	text[DONE + 1];
+	unsigned char	len[DONE + 1];
+};
+
+static constexpr SpellingTable BuildSpellings()
+{
+	SpellingTable t = {};
+	for( const Keyword& kw : kwlist ) {
+		t.text[kw.token] = kw.name;
+		t.len[kw.token] = kw.len;
+	}
+	for( const Operator& op : oplist ) {
+		t.text[op.token] = op.spelling;
+		t.len[op.token] = op.spelling[1] == 0 ? 1 : 2;
+	}
+	t.text[DONE] = "";
+	return t;
+}
+
+static constexpr SpellingTable spellings = BuildSpellings();
+
+//Token with the fixed spelling of spelled (a keyword, operator or DONE)
+static inline LexItem SpelledItem(Token tt, Token spelled, int linenum)
+{
+	return LexItem(tt, spellings.text[spelled], spellings.len[spelled], linenum);
+}
+
+//Token whose text is a string literal
+template <size_t N>
+static inline LexItem LiteralItem(Token tt, const char (&text)[N], int linenum)
+{
+	return LexItem(tt, text, N - 1, linenum);
+}
+
+const char* LexemePool::Copy(const char* s, size_t len)
+{
+	char* copy;
+	if( len > BLOCK / 4 ) {
+		//a long text gets a block of its own
+		blocks.emplace_back(new char[len]);
+		copy = blocks.back().get();
+	}
+	else {
+		if( len > left ) {
+			blocks.emplace_back(new char[BLOCK]);
+			next = blocks.back().get();
+			left = BLOCK;
+		}
+		copy = next;
+		next += len;
+		left -= len;
+	}
+	memcpy(copy, s, len);
+	return copy;
+}
+
+void LexemePool::Adopt(LexemePool& other)
+{
+	for( unique_ptr<char[]>& block : other.blocks )
+		blocks.push_back(move(block));
+	other.blocks.clear();
+	other.next = NULL;
+	other.left = 0;
+}
+
+LexItem::LexItem(Token token, const string& lexeme, int line, LexemePool& pool) : LexItem(token, "", 0, line)
+{
+	Token spelled = token == BCONST ? (lexeme == "true" ? TRUE : FALSE) : token;
+	const char* fixed = spellings.text[spelled];
+	if( fixed != NULL && lexeme == fixed ) {
+		text = fixed;
+		len = spellings.len[spelled];
+		return;
+	}
+	len = min(lexeme.length(), MAXLEN);
+	text = pool.Copy(lexeme.data(), len);
+}
+
+//first character of the next token at or after p, past white space and comments
+static inline const char* SkipBlank(const char* p, const char* end, int& linenum)
+{
+	while( true ) {
+		p = SkipSpace(p, end, linenum);
+		if( p == end || p[0] != '-' || p + 1 == end || p[1] != '-' )
+			return p;
+
+		p = FindNewline(p + 2, end);
+		if( p == end )
+			return p;
+		p++;
+		linenum++;
+	}
+}
+
+void SkipBlanks(LexBuffer& buf, int& linenum)
+{
+	buf.cur = SkipBlank(buf.cur, buf.end, linenum);
+}
+
+LexItem getNextToken(LexBuffer& buf, int& linenum)
+{
+	const char* end = buf.end;
+	const char* p = SkipBlank(buf.cur, end, linenum);
+	const char* start;
+	Token tt;
+	unsigned char ch;
+
+	if( p == end ) {
+		buf.cur = p;
+		return SpelledItem(DONE, DONE, linenum);
+	}
+
+	ch = *p++;
+	CharClass cc = charClass[ch];
+	if( cc == C_LETTER || cc == C_ELETTER || cc == C_DIGIT ) {
+		//run the identifier/number automaton as far as it goes, then step back
+		//out of a state that only looked ahead ("12." not followed by a digit)
+		start = p - 1;
+		DfaState st = cc == C_DIGIT ? D_INT : D_ID;
+		while( p < end ) {
+			DfaState next = dfa.next[st][charClass[(unsigned char) *p]];
+			if( next == D_STOP )
+				break;
+			st = next;
+			p++;
+		}
+		if( st == D_DOTERR ) {
+			//"1.2." followed by a digit; the digit is not part of the lexeme
+			buf.cur = p - 1;
+			return LexItem(ERR, start, p - 1 - start, linenum);
+		}
+		if( dfa.back[st] != st )
+			st = dfa.back[st], p--;
+		else if( p == end ) {
+			//a token cut off by the end of input is dropped
+			buf.cur = p;
+			return SpelledItem(DONE, DONE, linenum);
+		}
+		buf.cur = p;
+
+		tt = dfa.token[st];
+		if( tt != IDENT )
+			return NumberItem(tt, start, p - start, linenum, *buf.pool);
+		tt = KwToken(start, p - start);
+		if( tt == IDENT )
+		{
+			return IdentItem(buf.names->Intern(start, p - start), *buf.names, linenum);
+		}
+		//keywords take their lower case spelling from the keyword table
+		return SpelledItem(tt == TRUE || tt == FALSE ? BCONST : tt, tt, linenum);
+	}
+
+	switch( ch ) {
+	case '\'':
+		if( p == end )
+			break;
+		if( *p == '\n' ) {
+			buf.cur = p + 1;
+			return LiteralItem(ERR, "New line is an invalid character constant.", linenum);
+		}
+		if( *p == '\'' ) {
+			buf.cur = p + 1;
+			return LiteralItem(ERR, " Invalid character constant \'\'", linenum);
+		}
+		if( p + 1 == end )
+			break;
+		if( p[1] == '\n' ) {
+			buf.cur = p + 2;
+			return LiteralItem(ERR, "New line is an invalid character constant.", linenum);
+		}
+		buf.cur = p + 2;
+		if( p[1] == '\'' )
+			return LexItem(CCONST, p, 1, linenum);
+		return LexItem(ERR, " Invalid character constant \'" + string(p, p + 2) + "\'", linenum, *buf.pool);
+
+	case '\"':
+		//find the closing quote (or the newline that makes it illegal) in
+		//vector-width steps; the token points at the text in place
+		start = p;
+		p = FindStringEnd(p, end);
+		if( p == end )
+			break;
+		buf.cur = p + 1;
+		if( *p == '\n' )
+			return LexItem(ERR, " Invalid string constant \"" + string(start, p), linenum, *buf.pool);
+		if( (size_t) (p - start) > LexItem::MAXLEN )
+			return LiteralItem(ERR, "String constant too long", linenum);
+		return LexItem(SCONST, start, p - start, linenum);
+
+	default:
+		if( ops.second[ch] != 0 && p < end && *p == ops.second[ch] ) {
+			buf.cur = p + 1;
+			return SpelledItem(ops.pair[ch], ops.pair[ch], linenum);
+		}
+		buf.cur = p;
+		if( ops.single[ch] == ERR )
+			return LexItem(ERR, p - 1, 1, linenum);
+		return SpelledItem(ops.single[ch], ops.single[ch], linenum);
+	}
+
+	//input ran out inside a character or string constant
+	buf.cur = end;
+	return SpelledItem(DONE, DONE, linenum);
+}
@@ -0,0 +1,433 @@
+/* Lexer throughput comparison
+ * getNextToken(istream&) against getNextToken(LexBuffer&) on one source file,
+ * and keyword classification (id_or_kw) against the former per-call std::map lookup.
+ * -gen writes a synthetic SADAL program with a chosen token mix and then
+ * benchmarks it like any other file.
+ * lexBench_prog.cpp
+ *
+ * CS280 - Spring 2025
+ *
+ * build: g++ -O2 -std=c++17 -I../include lexBench_prog.cpp lex.cpp lexscan.cpp intern.cpp srcfile.cpp tokbuf.cpp lexstream.cpp -o lexbench -lpthread
+ * usage: lexbench <file> [repetitions] [scalar|sse2|avx2]
+ *        lexbench -gen <ident|numeric|string|comment|mixed> <megabytes> <file> [repetitions] [scalar|sse2|avx2]
+ *        lexbench -kw [identifiers]
+ */
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <chrono>
+#include <cstdlib>
+#include <vector>
+#include <map>
+#include <new>
+#include <algorithm>
+#include <thread>
+
+#include "lex.h"
+#include "srcfile.h"
+#include "lexscan.h"
+
+using namespace std;
+using namespace std::chrono;
+
+//every heap allocation in the program goes through here, so the scanners'
+//allocations per token can be read off allocCount around a run
+static long allocCount = 0;
+
+void* operator new(size_t size)
+{
+	allocCount++;
+	if( void* p = malloc(size ? size : 1) )
+		return p;
+	throw bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+	free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+	free(p);
+}
+
+//both scanners must yield the same tokens, lexemes and line numbers
+static bool SameTokens(const string& name, const SourceFile& src)
+{
+	ifstream file(name.c_str());
+	Interner names;
+	LexemePool pool;
+	LexBuffer buf(src.Data(), src.Size(), &names, &pool);
+	int line1 = 1, line2 = 1;
+	long count = 0;
+
+	while( true ) {
+		LexItem t1 = getNextToken(file, line1);
+		LexItem t2 = getNextToken(buf, line2);
+		//the stream scanner can't put back a character after peek() hit end of
+		//file ("12." at EOF); it then fails for good, where the buffer goes on
+		if( t1 == ERR && file.bad() )
+			return true;
+		if( t1.GetToken() != t2.GetToken() || t1.GetLexeme() != t2.GetLexeme() ||
+			t1.GetLinenum() != t2.GetLinenum() || line1 != line2 ||
+			(t1 == ICONST && t1.GetIntValue() != t2.GetIntValue()) ||
+			(t1 == FCONST && t1.GetRealValue() != t2.GetRealValue()) ) {
+			cerr << "token " << count << " differs: " << t1 << t2;
+			return false;
+		}
+		count++;
+		if( t1 == DONE )
+			return true;
+	}
+}
+
+static long LexStreamed(const string& name)
+{
+	ifstream file(name.c_str());
+	int line = 1;
+	long count = 0;
+	LexItem tok;
+	while( (tok = getNextToken(file, line)) != DONE && !file.bad() )
+		count++;
+	return count;
+}
+
+//LexStream with a given block size against the buffer scanner; tiny blocks
+//put a block boundary inside almost every token
+static bool SameBlocks(const string& name, const SourceFile& src, size_t block)
+{
+	ifstream file(name.c_str(), ios::binary);
+	Interner names;
+	LexStream strm(file, &names, block);
+	LexemePool pool;
+	LexBuffer buf(src.Data(), src.Size(), &names, &pool);
+	int line1 = 1, line2 = 1;
+
+	for( long count = 0; ; count++ ) {
+		LexItem t1 = strm.Next(line1);
+		LexItem t2 = getNextToken(buf, line2);
+		if( t1.GetToken() != t2.GetToken() || t1.GetLexeme() != t2.GetLexeme() ||
+			t1.GetLinenum() != t2.GetLinenum() || line1 != line2 ) {
+			cerr << "block size " << block << ": token " << count << " differs: " << t1 << t2;
+			return false;
+		}
+		if( t1 == DONE )
+			return true;
+	}
+}
+
+static long LexBlocks(const string& name)
+{
+	ifstream file(name.c_str(), ios::binary);
+	Interner names;
+	LexStream strm(file, &names);
+	int line = 1;
+	long count = 0;
+	while( strm.Next(line) != DONE )
+		count++;
+	return count;
+}
+
+static long LexBuffered(const SourceFile& src)
+{
+	Interner names;
+	LexemePool pool;
+	LexBuffer buf(src.Data(), src.Size(), &names, &pool);
+	int line = 1;
+	long count = 0;
+	while( getNextToken(buf, line) != DONE )
+		count++;
+	return count;
+}
+
+//Sequential and parallel token buffers must hold the same tokens
+static bool SameBuffers(const TokenBuffer& seq, const TokenBuffer& par)
+{
+	if( seq.Size() != par.Size() ) {
+		cerr << "parallel lexing made " << par.Size() << " tokens, not " << seq.Size() << endl;
+		return false;
+	}
+	for( size_t i = 0; i < seq.Size(); i++ ) {
+		LexItem t1 = seq.Item(i), t2 = par.Item(i);
+		if( t1.GetToken() != t2.GetToken() || t1.GetLexeme() != t2.GetLexeme() ||
+			t1.GetLinenum() != t2.GetLinenum() || t1.GetSymbol() != t2.GetSymbol() ||
+			(t1 == ICONST && t1.GetIntValue() != t2.GetIntValue()) ||
+			(t1 == FCONST && t1.GetRealValue() != t2.GetRealValue()) ) {
+			cerr << "parallel token " << i << " differs: " << t1 << t2;
+			return false;
+		}
+	}
+	return true;
+}
+
+static double LexIntoBuffer(const SourceFile& src, unsigned threads, TokenBuffer& toks,
+	Interner& names, int& line)
+{
+	toks = TokenBuffer();
+	names.Clear();
+	line = 1;
+	LexBuffer buf(src.Data(), src.Size(), &names);
+	auto t0 = steady_clock::now();
+	if( threads == 1 )
+		toks.Lex(buf, line);
+	else
+		toks.LexParallel(buf, line, threads);
+	return duration<double>(steady_clock::now() - t0).count();
+}
+
+static void Report(const char* label, double secs, long tokens, size_t bytes, long allocs)
+{
+	cout << label << ": " << fixed << setprecision(3) << secs << " s, "
+		<< setprecision(2) << tokens / secs / 1e6 << " Mtok/s, "
+		<< bytes / secs / (1024 * 1024) << " MB/s, "
+		<< (double) allocs / tokens << " allocations/token" << endl;
+}
+
+//Synthetic SADAL source. Every mix is syntactically a program: declarations up
+//front, then assignment and output statements whose operands lean towards one
+//token class, with comment lines sprinkled in.
+static string RandomName(int n)
+{
+	string id(1, 'A' + n % 26);
+	for( n /= 26; n > 0; n /= 36 )
+		id += "abcdefghijklmnopqrstuvwxyz0123456789"[n % 36];
+	return id;
+}
+
+static string Operand(const string& mix, const vector<string>& names)
+{
+	int r = rand() % 100;
+	if( mix == "numeric" ) {
+		if( r < 45 )
+			return to_string(rand() % 100000);
+		if( r < 90 )
+			return to_string(rand() % 1000) + "." + to_string(rand() % 10000) +
+				(r % 3 == 0 ? "E" + to_string(rand() % 20) : "");
+		return names[rand() % names.size()];
+	}
+	if( mix == "string" && r < 70 ) {
+		string str = "\"";
+		int len = rand() % 60;
+		for( int i = 0; i < len; i++ )
+			str += " abcdefghij klmnopqrstu vwxyzABCDE FGHIJKLMNO 0123456789,.;:!?"[rand() % 62];
+		return str + "\"";
+	}
+	if( mix == "ident" || r < 50 )
+		return names[rand() % names.size()];
+	return to_string(rand() % 1000);
+}
+
+static string Synthesize(const string& mix, size_t bytes)
+{
+	static const char* ops[] = { " + ", " - ", " * ", " / ", " & " };
+	vector<string> names;
+	for( int i = 0; i < 500; i++ )
+		names.push_back(RandomName(i * 7919 + 13));
+
+	srand(280);
+	string prog = "procedure " + mix + "bench is\n";
+	for( size_t i = 0; i < names.size(); i += 10 ) {
+		prog += "\t";
+		for( size_t j = i; j < i + 10 && j < names.size(); j++ )
+			prog += names[j] + (j + 1 < i + 10 ? ", " : " : integer;\n");
+	}
+	prog += "begin\n";
+
+	while( prog.size() < bytes ) {
+		if( mix == "comment" || rand() % 10 == 0 ) {
+			prog += "\t-- ";
+			int len = 20 + rand() % 60;
+			for( int i = 0; i < len; i++ )
+				prog += "abc def-ghi jkl;mno pqr:=stu vwx\"yz 0123 456.789"[rand() % 46];
+			prog += "\n";
+			if( mix == "comment" && rand() % 4 != 0 )
+				continue;
+		}
+		int terms = 1 + rand() % 5;
+		bool output = rand() % 4 == 0;
+		prog += output ? "\tputline(" : "\t" + names[rand() % names.size()] + " := ";
+		for( int i = 0; i < terms; i++ ) {
+			if( i > 0 )
+				prog += ops[rand() % 5];
+			prog += Operand(mix, names);
+		}
+		prog += output ? ");\n" : ";\n";
+	}
+	return prog + "end " + mix + "bench;\n";
+}
+
+//id_or_kw as it was before the static keyword table: a map rebuilt per identifier
+static LexItem MapIdOrKw(const string& lexeme, int linenum, LexemePool& pool)
+{
+	string strlexeme = lexeme;
+	map<string,Token> kwmap = {
+		{ "put", PUT}, { "putline", PUTLN}, { "get", GET},
+		{ "if", IF }, { "elsif", ELSIF }, { "else", ELSE },
+		{ "string", STRING }, { "integer", INT }, { "float", FLOAT },
+		{ "character", CHAR }, { "boolean", BOOL },
+		{ "procedure", PROCEDURE }, { "begin", BEGIN },
+		{ "true", TRUE }, { "then", THEN }, { "constant", CONST },
+		{ "false", FALSE }, { "is", IS }, { "end", END },
+		{ "mod", MOD }, { "and", AND }, { "or", OR }, { "not", NOT },
+	};
+	for( size_t i = 0; i < lexeme.length(); i++ )
+		strlexeme[i] = tolower(strlexeme[i]);
+
+	Token tt = IDENT;
+	auto kIt = kwmap.find(strlexeme);
+	if( kIt != kwmap.end() )
+		tt = kIt->second;
+	if( tt == TRUE || tt == FALSE )
+		tt = BCONST;
+	return LexItem(tt, lexeme, linenum, pool);
+}
+
+//Classify a mix of keywords (in mixed case) and plain identifiers both ways
+static int KeywordBench(int count)
+{
+	static const char* words[] = {
+		"put", "PutLine", "get", "if", "Elsif", "else", "string", "Integer", "float",
+		"character", "boolean", "Procedure", "begin", "true", "then", "constant",
+		"false", "is", "END", "mod", "and", "or", "not",
+	};
+	const int nwords = sizeof(words) / sizeof(words[0]);
+
+	vector<string> ids;
+	srand(280);
+	for( int i = 0; i < count; i++ ) {
+		if( i % 2 == 0 ) {
+			ids.push_back(words[rand() % nwords]);
+			continue;
+		}
+		string id(1, 'a' + rand() % 26);
+		int len = rand() % 12;
+		for( int j = 0; j < len; j++ )
+			id += "abcdefghijklmnopqrstuvwxyz_0123456789"[rand() % 37];
+		ids.push_back(id);
+	}
+
+	Interner names;
+	LexemePool pool;
+	long keywords1 = 0, keywords2 = 0;
+	auto t0 = steady_clock::now();
+	for( size_t i = 0; i < ids.size(); i++ )
+		keywords1 += MapIdOrKw(ids[i], 1, pool) != IDENT;
+	auto t1 = steady_clock::now();
+	for( size_t i = 0; i < ids.size(); i++ )
+		keywords2 += id_or_kw(ids[i], 1, names, pool) != IDENT;
+	auto t2 = steady_clock::now();
+
+	for( size_t i = 0; i < ids.size(); i++ ) {
+		if( MapIdOrKw(ids[i], 1, pool).GetToken() != id_or_kw(ids[i], 1, names, pool).GetToken() ) {
+			cerr << "classification differs for " << ids[i] << endl;
+			return 1;
+		}
+	}
+
+	double secs1 = duration<double>(t1 - t0).count(), secs2 = duration<double>(t2 - t1).count();
+	cout << ids.size() << " identifiers, " << keywords2 << " keywords" << endl;
+	cout << "std::map : " << fixed << setprecision(1) << secs1 * 1e9 / ids.size() << " ns/identifier" << endl;
+	cout << "kw table : " << secs2 * 1e9 / ids.size() << " ns/identifier" << endl;
+	cout << "speedup: " << setprecision(2) << secs1 / secs2 << "x" << endl;
+	return keywords1 == keywords2 ? 0 : 1;
+}
+
+int main(int argc, char *argv[])
+{
+	if( argc < 2 ) {
+		cerr << "usage: " << argv[0] << " <file> [repetitions] [scalar|sse2|avx2]" << endl;
+		cerr << "       " << argv[0] << " -gen <ident|numeric|string|comment|mixed> <megabytes> <file> [repetitions] [scalar|sse2|avx2]" << endl;
+		cerr << "       " << argv[0] << " -kw [identifiers]" << endl;
+		return 1;
+	}
+	if( string(argv[1]) == "-kw" )
+		return KeywordBench(argc > 2 ? atoi(argv[2]) : 1000000);
+
+	int arg = 1;
+	if( string(argv[1]) == "-gen" ) {
+		static const char* mixes[] = { "ident", "numeric", "string", "comment", "mixed" };
+		if( argc < 5 || find(begin(mixes), end(mixes), string(argv[2])) == end(mixes) ) {
+			cerr << "usage: " << argv[0] << " -gen <ident|numeric|string|comment|mixed> <megabytes> <file>" << endl;
+			return 1;
+		}
+		ofstream out(argv[4]);
+		out << Synthesize(argv[2], (size_t) (atof(argv[3]) * 1024 * 1024));
+		if( !out ) {
+			cerr << "CANNOT WRITE " << argv[4] << endl;
+			return 1;
+		}
+		arg = 4;
+	}
+
+	string name = argv[arg];
+	int reps = argc > arg + 1 ? atoi(argv[arg + 1]) : 5;
+	if( argc > arg + 2 && !SetScanLevel(argv[arg + 2]) ) {
+		cerr << argv[arg + 2] << " scanning is not available here" << endl;
+		return 1;
+	}
+
+	SourceFile src;
+	if( !src.Open(name) ) {
+		cerr << "CANNOT OPEN " << name << endl;
+		return 1;
+	}
+	if( !SameTokens(name, src) )
+		return 1;
+	for( size_t block : { 1, 2, 3, 7, 64, 4096, (int) LexStream::BLOCK } )
+		if( !SameBlocks(name, src, block) )
+			return 1;
+
+	//whole token buffers, sequential against parallel; a thread count is
+	//forced so that small files get cut into chunks too
+	unsigned cores = max(2u, thread::hardware_concurrency());
+	TokenBuffer seq, par;
+	Interner seqNames, parNames;
+	int seqLine, parLine;
+	double bestSeq = 1e30, bestPar = 1e30;
+	for( unsigned n = 2; n <= max(8u, cores); n *= 2 ) {
+		LexIntoBuffer(src, 1, seq, seqNames, seqLine);
+		LexIntoBuffer(src, n, par, parNames, parLine);
+		if( !SameBuffers(seq, par) || seqLine != parLine ) {
+			cerr << "(" << n << " threads)" << endl;
+			return 1;
+		}
+	}
+
+	long tokens = 0, allocs1 = 0, allocs2 = 0;
+	double best1 = 1e30, best2 = 1e30, bestBlocks = 1e30;
+	for( int r = 0; r < reps; r++ ) {
+		long a0 = allocCount;
+		auto t0 = steady_clock::now();
+		tokens = LexStreamed(name);
+		auto t1 = steady_clock::now();
+		long a1 = allocCount;
+		LexBuffered(src);
+		auto t2 = steady_clock::now();
+		allocs1 = a1 - a0;
+		allocs2 = allocCount - a1;
+		best1 = min(best1, duration<double>(t1 - t0).count());
+		best2 = min(best2, duration<double>(t2 - t1).count());
+		auto t3 = steady_clock::now();
+		LexBlocks(name);
+		bestBlocks = min(bestBlocks, duration<double>(steady_clock::now() - t3).count());
+		bestSeq = min(bestSeq, LexIntoBuffer(src, 1, seq, seqNames, seqLine));
+		bestPar = min(bestPar, LexIntoBuffer(src, cores, par, parNames, parLine));
+	}
+
+	cout << name << ": " << src.Size() << " bytes, " << tokens << " tokens, best of " << reps
+		<< ", " << ScanLevel() << " scanning" << endl;
+	Report("istream", best1, tokens, src.Size(), allocs1);
+	Report("buffer ", best2, tokens, src.Size(), allocs2);
+	cout << "speedup: " << setprecision(2) << best1 / best2 << "x" << endl;
+	cout << "LexStream: " << setprecision(3) << bestBlocks << " s, "
+		<< setprecision(2) << src.Size() / bestBlocks / (1024 * 1024) << " MB/s, "
+		<< best1 / bestBlocks << "x the istream scanner" << endl;
+	cout << "token buffer, 1 thread: " << setprecision(3) << bestSeq << " s, "
+		<< setprecision(2) << src.Size() / bestSeq / (1024 * 1024) << " MB/s" << endl;
+	cout << "token buffer, " << cores << " threads: " << setprecision(3) << bestPar << " s, "
+		<< setprecision(2) << src.Size() / bestPar / (1024 * 1024) << " MB/s, "
+		<< bestSeq / bestPar << "x" << endl;
+	return 0;
+}
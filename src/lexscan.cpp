@@ -0,0 +1,235 @@
+/*
+ * lexscan.cpp
+ * Vectorized white space and comment skipping for the SADAL lexer
+ * CS280 - Spring 2025
+ */
+
+#include <cctype>
+#include <cstring>
+
+#include "lexscan.h"
+
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#define LEXSCAN_X86 1
+#include <immintrin.h>
+#endif
+
+//white space as isspace() sees it in the C locale: ' ' and '\t' .. '\r'
+static inline bool IsSpace(unsigned char c)
+{
+	return c == ' ' || (unsigned char) (c - '\t') <= '\r' - '\t';
+}
+
+static const char* SkipSpaceScalar(const char* p, const char* end, int& linenum)
+{
+	while( p < end && IsSpace(*p) ) {
+		if( *p == '\n' )
+			linenum++;
+		p++;
+	}
+	return p;
+}
+
+static const char* FindNewlineScalar(const char* p, const char* end)
+{
+	const void* nl = memchr(p, '\n', end - p);
+	return nl != NULL ? (const char*) nl : end;
+}
+
+static const char* FindStringEndScalar(const char* p, const char* end)
+{
+	while( p < end && *p != '\"' && *p != '\n' )
+		p++;
+	return p;
+}
+
+#ifdef LEXSCAN_X86
+
+static const char* SkipSpaceSSE2(const char* p, const char* end, int& linenum)
+{
+	const __m128i space = _mm_set1_epi8(' ');
+	const __m128i tab = _mm_set1_epi8('\t');
+	const __m128i span = _mm_set1_epi8('\r' - '\t');
+	const __m128i newline = _mm_set1_epi8('\n');
+
+	while( end - p >= 16 ) {
+		__m128i v = _mm_loadu_si128((const __m128i*) p);
+		__m128i ctl = _mm_sub_epi8(v, tab);
+		__m128i ws = _mm_or_si128(_mm_cmpeq_epi8(v, space),
+			_mm_cmpeq_epi8(_mm_min_epu8(ctl, span), ctl));
+		unsigned other = ~(unsigned) _mm_movemask_epi8(ws) & 0xFFFF;
+		unsigned nl = (unsigned) _mm_movemask_epi8(_mm_cmpeq_epi8(v, newline));
+		if( other != 0 ) {
+			int n = __builtin_ctz(other);
+			linenum += __builtin_popcount(nl & ((1u << n) - 1));
+			return p + n;
+		}
+		linenum += __builtin_popcount(nl);
+		p += 16;
+	}
+	return SkipSpaceScalar(p, end, linenum);
+}
+
+static const char* FindNewlineSSE2(const char* p, const char* end)
+{
+	const __m128i newline = _mm_set1_epi8('\n');
+
+	while( end - p >= 16 ) {
+		__m128i v = _mm_loadu_si128((const __m128i*) p);
+		unsigned nl = (unsigned) _mm_movemask_epi8(_mm_cmpeq_epi8(v, newline));
+		if( nl != 0 )
+			return p + __builtin_ctz(nl);
+		p += 16;
+	}
+	return FindNewlineScalar(p, end);
+}
+
+static const char* FindStringEndSSE2(const char* p, const char* end)
+{
+	const __m128i quote = _mm_set1_epi8('\"');
+	const __m128i newline = _mm_set1_epi8('\n');
+
+	while( end - p >= 16 ) {
+		__m128i v = _mm_loadu_si128((const __m128i*) p);
+		unsigned hit = (unsigned) _mm_movemask_epi8(
+			_mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, newline)));
+		if( hit != 0 )
+			return p + __builtin_ctz(hit);
+		p += 16;
+	}
+	return FindStringEndScalar(p, end);
+}
+
+__attribute__((target("avx2")))
+static const char* SkipSpaceAVX2(const char* p, const char* end, int& linenum)
+{
+	const __m256i space = _mm256_set1_epi8(' ');
+	const __m256i tab = _mm256_set1_epi8('\t');
+	const __m256i span = _mm256_set1_epi8('\r' - '\t');
+	const __m256i newline = _mm256_set1_epi8('\n');
+
+	while( end - p >= 32 ) {
+		__m256i v = _mm256_loadu_si256((const __m256i*) p);
+		__m256i ctl = _mm256_sub_epi8(v, tab);
+		__m256i ws = _mm256_or_si256(_mm256_cmpeq_epi8(v, space),
+			_mm256_cmpeq_epi8(_mm256_min_epu8(ctl, span), ctl));
+		unsigned other = ~(unsigned) _mm256_movemask_epi8(ws);
+		unsigned nl = (unsigned) _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, newline));
+		if( other != 0 ) {
+			int n = __builtin_ctz(other);
+			linenum += __builtin_popcount(nl & ((1ull << n) - 1));
+			return p + n;
+		}
+		linenum += __builtin_popcount(nl);
+		p += 32;
+	}
+	return SkipSpaceSSE2(p, end, linenum);
+}
+
+__attribute__((target("avx2")))
+static const char* FindNewlineAVX2(const char* p, const char* end)
+{
+	const __m256i newline = _mm256_set1_epi8('\n');
+
+	while( end - p >= 32 ) {
+		__m256i v = _mm256_loadu_si256((const __m256i*) p);
+		unsigned nl = (unsigned) _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, newline));
+		if( nl != 0 )
+			return p + __builtin_ctz(nl);
+		p += 32;
+	}
+	return FindNewlineSSE2(p, end);
+}
+
+__attribute__((target("avx2")))
+static const char* FindStringEndAVX2(const char* p, const char* end)
+{
+	const __m256i quote = _mm256_set1_epi8('\"');
+	const __m256i newline = _mm256_set1_epi8('\n');
+
+	while( end - p >= 32 ) {
+		__m256i v = _mm256_loadu_si256((const __m256i*) p);
+		unsigned hit = (unsigned) _mm256_movemask_epi8(
+			_mm256_or_si256(_mm256_cmpeq_epi8(v, quote), _mm256_cmpeq_epi8(v, newline)));
+		if( hit != 0 )
+			return p + __builtin_ctz(hit);
+		p += 32;
+	}
+	return FindStringEndSSE2(p, end);
+}
+
+#endif
+
+struct ScanRoutines {
+	const char*	level;
+	const char*	(*skipSpace)(const char*, const char*, int&);
+	const char*	(*findNewline)(const char*, const char*);
+	const char*	(*findStringEnd)(const char*, const char*);
+};
+
+static const ScanRoutines scalarRoutines = { "scalar", SkipSpaceScalar, FindNewlineScalar, FindStringEndScalar };
+#ifdef LEXSCAN_X86
+static const ScanRoutines sse2Routines = { "sse2", SkipSpaceSSE2, FindNewlineSSE2, FindStringEndSSE2 };
+static const ScanRoutines avx2Routines = { "avx2", SkipSpaceAVX2, FindNewlineAVX2, FindStringEndAVX2 };
+#endif
+
+static const ScanRoutines* PickRoutines()
+{
+#ifdef LEXSCAN_X86
+	__builtin_cpu_init();
+	if( __builtin_cpu_supports("avx2") )
+		return &avx2Routines;
+	return &sse2Routines;
+#else
+	return &scalarRoutines;
+#endif
+}
+
+static const ScanRoutines* scan = PickRoutines();
+
+const char* SkipSpace(const char* p, const char* end, int& linenum)
+{
+	//most gaps between tokens are a single blank or none at all
+	if( p == end || !IsSpace(*p) )
+		return p;
+	if( p + 1 < end && !IsSpace(p[1]) ) {
+		if( *p == '\n' )
+			linenum++;
+		return p + 1;
+	}
+	return scan->skipSpace(p, end, linenum);
+}
+
+const char* FindNewline(const char* p, const char* end)
+{
+	return scan->findNewline(p, end);
+}
+
+const char* FindStringEnd(const char* p, const char* end)
+{
+	return scan->findStringEnd(p, end);
+}
+
+const char* ScanLevel()
+{
+	return scan->level;
+}
+
+bool SetScanLevel(const string& level)
+{
+	if( level == "scalar" ) {
+		scan = &scalarRoutines;
+		return true;
+	}
+#ifdef LEXSCAN_X86
+	if( level == "sse2" ) {
+		scan = &sse2Routines;
+		return true;
+	}
+	if( level == "avx2" && __builtin_cpu_supports("avx2") ) {
+		scan = &avx2Routines;
+		return true;
+	}
+#endif
+	return false;
+}
@@ -0,0 +1,81 @@
+/*
+ * lexstream.cpp
+ * Block-buffered lexing of a SADAL program read from a stream
+ * CS280 - Spring 2025
+ */
+
+#include <cstring>
+
+#include "lex.h"
+
+LexStream::LexStream(istream& in, Interner* names, size_t block)
+	: in(in), block(block), data(block), eof(false), names(names), texts(TEXTSLOTS), nextText(0)
+{
+	cur = lineEnd = fill = data.data();
+}
+
+//Keep the unscanned tail, then read until the buffer holds at least one more
+//complete line (or the input ends). The buffer only grows while a line is
+//longer than what it can hold.
+void LexStream::Refill()
+{
+	size_t keep = fill - cur;
+	char* base = data.data();
+	memmove(base, cur, keep);
+	cur = base;
+	fill = base + keep;
+
+	while( !eof ) {
+		size_t room = data.data() + data.size() - fill;
+		if( room < block / 2 + 1 ) {
+			size_t used = fill - data.data();
+			data.resize(data.size() + block);
+			cur = data.data();
+			fill = cur + used;
+			room = data.size() - used;
+		}
+		in.read((char*) fill, room);
+		size_t got = in.gcount();
+		eof = got < room;
+		const char* from = fill;
+		fill += got;
+		if( memchr(from, '\n', got) != NULL )
+			break;
+	}
+
+	lineEnd = cur;
+	for( const char* p = fill; p > cur; p-- ) {
+		if( p[-1] == '\n' ) {
+			lineEnd = p;
+			break;
+		}
+	}
+}
+
+LexItem LexStream::Next(int& linenum)
+{
+	//skip blank space and comments a buffer at a time until a token starts
+	//inside the complete lines at hand
+	while( true ) {
+		LexBuffer win(cur, (eof ? fill : lineEnd) - cur, names, &pool);
+		SkipBlanks(win, linenum);
+		cur = win.cur;
+		if( cur < lineEnd || eof )
+			break;
+		Refill();
+	}
+
+	LexBuffer win(cur, (eof ? fill : lineEnd) - cur, names, &pool);
+	LexItem tok = getNextToken(win, linenum);
+	cur = win.cur;
+
+	//text still pointing into the buffer is about to be overwritten by a refill
+	string_view text = tok.Text();
+	if( text.data() >= data.data() && text.data() < data.data() + data.size() ) {
+		string& slot = texts[nextText];
+		nextText = (nextText + 1) % TEXTSLOTS;
+		slot.assign(text.data(), text.size());
+		tok = LexItem(tok.GetToken(), slot.data(), slot.size(), tok.GetLinenum());
+	}
+	return tok;
+}
@@ -8,56 +8,137 @@
 #include <vector>
 #include <map>
 #include <algorithm>
+#include <cassert>
 #include "parserInterp.h"
 #include "val.h"
 
 using namespace std;
 
-// Global variables
-string declaredProcName;
-map<string, bool> defVar;
-map<string, Token> SymTable;       // Tracks variable types
-map<string, Value> TempsResults;   // Stores variable values
+// The parser's state only lasts one call of Parse, which starts it afresh; it
+// is kept per thread, so programs can be parsed on several threads at once.
+
+// The program being built
+static thread_local Program* prog = NULL;
 
 using namespace std;
 
 namespace Parser {
-	bool pushed_back = false;
-	LexItem pushed_token;
+	// Tokens read from the source and not consumed yet, behind them the last
+	// few consumed, in a ring of fixed size: the parser looks ahead at tokens
+	// and steps back over one without copying or reading it again, and the
+	// ring is never reallocated. It holds no more tokens than a LexStream keeps
+	// texts for, so every token in it still has its text.
+	class Lookahead {
+	public:
+		static const size_t SIZE = 16;
+
+		void Clear() {
+			head = tail = 0;
+			marked = false;
+			stepped = true;
+		}
 
-	static LexItem GetNextToken(istream& in, int& line) {
-		if (pushed_back) {
-			pushed_back = false;
-			return pushed_token;
+		// the token k places after the next one, k < SIZE - 1, read as far as
+		// need be; line is left where reading them would leave it, and Last
+		// as if they had been read and stepped back over
+		const LexItem& Peek(LexSource& in, int& line, size_t k = 0) {
+			// any further and the token before the next one, which Back
+			// returns to, would be overwritten
+			assert(k < SIZE - 1);
+			stepped = true;
+			while (tail - head <= k) {
+				// a mark is let go of rather than overwritten
+				if (marked && tail - mark == SIZE) {
+					marked = false;
+				}
+				items[tail++ % SIZE] = in.Next(line);
+			}
+			return items[(head + k) % SIZE];
+		}
+
+		const LexItem& Next(LexSource& in, int& line) {
+			const LexItem& tok = Peek(in, line);
+			head++;
+			stepped = false;
+			return tok;
+		}
+
+		// step back over the last token consumed
+		void Back() {
+			head--;
+			stepped = true;
+		}
+
+		// the last token consumed, ERR if the parser has looked ahead or
+		// stepped back since
+		LexItem Last() const {
+			return stepped ? LexItem() : items[(head - 1) % SIZE];
 		}
-		return getNextToken(in, line);
-	}
 
-	static void PushBackToken(LexItem & t) {
-		if (pushed_back) {
-			abort();
+		// remember where the parser is, to go back there with Reset; there is
+		// one mark, which is lost once SIZE tokens have been read past it
+		void Mark() {
+			mark = head;
+			marked = true;
 		}
-		pushed_back = true;
-		pushed_token = t;	
+
+		// back to the mark, false if it has been lost; line stays where the
+		// furthest token read left it
+		bool Reset() {
+			if (!marked) {
+				return false;
+			}
+			head = mark;
+			marked = false;
+			stepped = true;
+			return true;
+		}
+
+	private:
+		LexItem	items[SIZE];
+		size_t	head = 0;	// tokens consumed
+		size_t	tail = 0;	// tokens read from the source
+		size_t	mark = 0;
+		bool	marked = false;
+		bool	stepped = true;	// nothing consumed since a look ahead or step back
+	};
+
+	static_assert(Lookahead::SIZE <= LexStream::TEXTSLOTS,
+		"a token in the lookahead ring could outlive its text");
+
+	thread_local Lookahead tokens;
+	// syntax errors of the construct being parsed, not yet reported
+	thread_local vector<SyntaxMsg> errors;
+
+	static LexItem GetNextToken(LexSource& in, int& line) {
+		return tokens.Next(in, line);
 	}
 
-}
+	static const LexItem& Peek(LexSource& in, int& line, size_t k = 0) {
+		return tokens.Peek(in, line, k);
+	}
 
-static int error_count = 0;
+	static void PushBackToken() {
+		tokens.Back();
+	}
+
+	// hand over the errors collected so far
+	static Span<SyntaxMsg> TakeErrors() {
+		Span<SyntaxMsg> taken = prog->Copy(errors);
+		errors.clear();
+		return taken;
+	}
 
-int ErrCount()
-{
-    return error_count;
 }
 
-void ParseError(int line, string msg)
+// Syntax errors are held until execution gets to them
+static void ParseError(int line, string msg)
 {
-	++error_count;
-	cout << line << ": " << msg << endl;
+	Parser::errors.push_back({line, prog->Text(msg)});
 }
 
 // 3. ProcName ::= IDENT
-bool ProcName(istream& in, int& line) {
+bool ProcName(LexSource& in, int& line) {
     LexItem tok;
 	tok = Parser::GetNextToken(in, line);
 	if (tok != IDENT) {
@@ -67,10 +148,15 @@ bool ProcName(istream& in, int& line) {
 }
 
 //Prog ::= PROCEDURE ProcName IS ProcBody
-bool Prog(istream& in, int& line) {
+bool Parse(LexSource& in, int& line, Program& program) {
+    prog = &program;
+    Parser::tokens.Clear();
+    Parser::errors.clear();
+
     LexItem tok = Parser::GetNextToken(in, line);
     if (tok != PROCEDURE) {
         ParseError(line, "Incorrect compilation file.");
+        prog->headErrors = Parser::TakeErrors();
         return false;
     }
 
@@ -78,33 +164,40 @@ bool Prog(istream& in, int& line) {
     tok = Parser::GetNextToken(in, line);
     if (tok != IDENT) {
         ParseError(line, "Missing Procedure Name.");
+        prog->headErrors = Parser::TakeErrors();
         return false;
     }
-    declaredProcName = tok.GetLexeme();
-    defVar[declaredProcName] = true;  
+    prog->procName = tok.GetSymbol();
 
     tok = Parser::GetNextToken(in, line);
     if (tok != IS) {
         ParseError(line, "Missing IS Keyword");
+        prog->headErrors = Parser::TakeErrors();
         return false;
     }
 
-    bool procBodyStatus = ProcBody(in, line);
-    if (!procBodyStatus) {
-        ParseError(line, "Incorrect Procedure Definition.");
-        ParseError(line, "Incorrect Procedure Body");
-        return false;
-    }
-    
-    if (error_count == 0) {
-        cout << endl << "(DONE)" << endl;
-    }
-    
-    return true;
+    bool status = ProcBody(in, line);
+    Fold(*prog);
+    return status;
+}
+
+//Parse the whole program, then run it
+bool Prog(LexSource& in, int& line) {
+    Program program;
+    Parse(in, line, program);
+    return Execute(program);
+}
+
+//Prog over a stream, read and lexed a block at a time
+bool Prog(istream& in, int& line) {
+    Interner names;
+    LexStream strm(in, &names);
+    LexSource src(strm);
+    return Prog(src, line);
 }
 
 // 2. ProcBody ::= DeclPart BEGIN StmtList END ProcName ;
-bool ProcBody(istream& in, int& line) {
+bool ProcBody(LexSource& in, int& line) {
     LexItem tok;
     
     // 1. Check DeclPart
@@ -116,12 +209,15 @@ bool ProcBody(istream& in, int& line) {
     tok = Parser::GetNextToken(in, line);
     if (tok != BEGIN) {
         ParseError(line, "Missing BEGIN keyword for procedure body");
+        prog->bodyErrors = Parser::TakeErrors();
         return false;
     }
     
     // 3. Check StmtList
-    if (!StmtList(in, line)) {
-        //ParseError(line, "Syntactic error in statement list");
+    vector<StmtNode*> body;
+    bool status = StmtList(in, line, body);
+    prog->body = prog->Copy(body);
+    if (!status) {
         return false;    
     }
     
@@ -129,12 +225,14 @@ bool ProcBody(istream& in, int& line) {
     tok = Parser::GetNextToken(in, line);
     if (tok != END) {
         ParseError(line, "Missing END keyword");
+        prog->bodyErrors = Parser::TakeErrors();
         return false;
     }
     
     tok = Parser::GetNextToken(in, line);
-    if (tok != IDENT || tok.GetLexeme() != declaredProcName) {
+    if (tok != IDENT || tok.GetSymbol() != prog->procName) {
         ParseError(line, "Procedure name mismatch in closing end identifier.");
+        prog->bodyErrors = Parser::TakeErrors();
         return false;
     }
 
@@ -143,38 +241,23 @@ bool ProcBody(istream& in, int& line) {
 
 
 // DeclPart ::= DeclStmt { DeclStmt }
-bool DeclPart(istream& in, int& line) {
-    LexItem tok;
+// A declaration that does not parse is the last one kept
+bool DeclPart(LexSource& in, int& line) {
+    vector<DeclNode*> decls;
+    bool status = DeclStmt(in, line, decls);
     
-    if (!DeclStmt(in, line)) {
-        ParseError(line, "Non-recognizable Declaration Part.");
-        return false;
+    while (status && Parser::Peek(in, line) != BEGIN && Parser::Peek(in, line) != END) {
+        status = DeclStmt(in, line, decls);
     }
-    
-    tok = Parser::GetNextToken(in, line);
-    while (tok != BEGIN && tok!= END) {
-        Parser::PushBackToken(tok);
-        
-        if (!DeclStmt(in, line)) {
-            ParseError(line, "Invalid declaration.");
-            return false;
-        }
-        
-        tok = Parser::GetNextToken(in, line);
-    }
-    
-    Parser::PushBackToken(tok);
-    return true;
+    prog->decls = prog->Copy(decls);
+    return status;
 }
 
 
 // 5. DeclStmt ::= IDENT {, IDENT } : Type [:= Expr] ;
-bool DeclStmt(istream& in, int& line) {
+static bool ParseDecl(LexSource& in, int& line, DeclNode* decl) {
     LexItem tok;
-    vector<string> identifiers;
-    Token varType;
-    Value initVal;
-    bool hasInit = false;
+    vector<LexItem> identifiers;
 
     // 1. Parse identifier list
     tok = Parser::GetNextToken(in, line);
@@ -182,22 +265,22 @@ bool DeclStmt(istream& in, int& line) {
         ParseError(line, "Missing identifier in declaration");
         return false;
     }
-    identifiers.push_back(tok.GetLexeme());
+    identifiers.push_back(tok);
 
     // Parse additional identifiers separated by commas
     while (true) {
-        tok = Parser::GetNextToken(in, line);
+        const LexItem& next = Parser::Peek(in, line);
         
-        if (tok == STRING) {
-            ParseError(line, "Invalid name for an Identifier: " + tok.GetLexeme());
+        if (next == STRING) {
+            ParseError(line, "Invalid name for an Identifier: " + next.GetLexeme());
             return false;
         }
 
-        if (tok != COMMA) {
-            Parser::PushBackToken(tok);
+        if (next != COMMA) {
             break;
         }
 
+        Parser::GetNextToken(in, line);
         tok = Parser::GetNextToken(in, line);
         if (tok != IDENT) {
             ParseError(line, "Missing identifier after comma");
@@ -205,11 +288,13 @@ bool DeclStmt(istream& in, int& line) {
         }
         
         // Check for duplicate identifiers in this declaration
-        if (find(identifiers.begin(), identifiers.end(), tok.GetLexeme()) != identifiers.end()) {
+        int sym = tok.GetSymbol();
+        if (find_if(identifiers.begin(), identifiers.end(),
+                    [sym](const LexItem& id) { return id.GetSymbol() == sym; }) != identifiers.end()) {
             ParseError(line, "Duplicate identifier in declaration: " + tok.GetLexeme());
             return false;
         }
-        identifiers.push_back(tok.GetLexeme());
+        identifiers.push_back(tok);
     }
 
     // 2. Check for colon
@@ -225,45 +310,16 @@ bool DeclStmt(istream& in, int& line) {
         ParseError(line, "Invalid type specification");
         return false;
     }
-    varType = tok.GetToken();
+    decl->type = tok.GetToken();
 
-    // 4. Check for initialization
-    tok = Parser::GetNextToken(in, line);
-    if (tok == ASSOP) {
-        hasInit = true;
-        if (!Expr(in, line, initVal)) {
+    // 4. Check for initialization; its type is checked when it runs
+    if (Parser::Peek(in, line) == ASSOP) {
+        Parser::GetNextToken(in, line);
+        if (!Expr(in, line, decl->init)) {
             ParseError(line, "Invalid initialization expression");
             return false;
         }
-
-        // Verify type compatibility
-        bool typeError = false;
-        switch(varType) {
-            case INT:
-                if (!initVal.IsInt()) typeError = true;
-                break;
-            case FLOAT:
-                if (!initVal.IsReal()) typeError = true;
-                break;
-            case BOOL:
-                if (!initVal.IsBool()) typeError = true;
-                break;
-            case STRING:
-                if (!initVal.IsString()) typeError = true;
-                break;
-            case CHAR:
-                if (!initVal.IsChar()) typeError = true;
-                break;
-            default:
-                typeError = true;
-        }
-
-        if (typeError) {
-            ParseError(line, "Type mismatch in initialization");
-            return false;
-        }
-    } else {
-        Parser::PushBackToken(tok);
+        decl->initLine = line;
     }
 
     // 5. Check for semicolon
@@ -272,30 +328,40 @@ bool DeclStmt(istream& in, int& line) {
         ParseError(line, "Missing semicolon at end of declaration");
         return false;
     }
-
-    // 6. Register variables in symbol table and initialize if needed
-    for (const auto& id : identifiers) {
-        // Check for previous declaration
-        if (SymTable.find(id) != SymTable.end()) {
-            ParseError(line, "Variable redefinition: " + id);
-            return false;
-        }
-
-        // Add to symbol table
-        SymTable[id] = varType;
-        
-        // Initialize if needed
-        if (hasInit) {
-            TempsResults[id] = initVal;
+    decl->line = line;
+
+    // 6. Give each new variable its frame slot; a redefinition is reported
+    //    when the declaration runs, after its initializer
+    vector<int> slots;
+    for (const LexItem& id : identifiers) {
+        int slot = prog->SlotOf(id.GetSymbol());
+        if (slot >= 0) {
+            if (decl->redefined < 0)
+                decl->redefined = slot;
+            slots.push_back(slot);
+            continue;
         }
+        slots.push_back(prog->Declare(id.GetSymbol(), id.Text(), decl->type));
     }
+    decl->slots = prog->Copy(slots);
 
     return true;
 }
 
+bool DeclStmt(LexSource& in, int& line, vector<DeclNode*>& decls) {
+    DeclNode* decl = prog->NewDecl();
+    decls.push_back(decl);
+
+    if (!ParseDecl(in, line, decl)) {
+        decl->errors = Parser::TakeErrors();
+        return false;
+    }
+    return true;
+}
+
 
 // 6. Type ::= INTEGER | FLOAT | BOOLEAN | STRING | CHARACTER
-bool Type(istream& in, int& line) {
+bool Type(LexSource& in, int& line) {
     LexItem tok = Parser::GetNextToken(in, line);
     
     if (tok != INT && tok != FLOAT && tok != BOOL && tok != STRING && tok != CHAR) {
@@ -306,64 +372,57 @@ bool Type(istream& in, int& line) {
 }
 
 // 7. StmtList ::= Stmt { Stmt }
-bool StmtList(istream& in, int& line) {
-    bool status;
-    LexItem tok;
-    
-    status = Stmt(in, line);
-    if (!status) {
-        ParseError(line, "Syntactic error in statement list.");
+// A statement that does not parse is the last one kept
+bool StmtList(LexSource& in, int& line, vector<StmtNode*>& list) {
+    if (!Stmt(in, line, list)) {
         return false;
     }
     
-    tok = Parser::GetNextToken(in, line);
-    while (tok != END && tok != ELSIF && tok != ELSE) {
-        Parser::PushBackToken(tok);
+    while (true) {
+        const LexItem& tok = Parser::Peek(in, line);
+        if (tok == END || tok == ELSIF || tok == ELSE) {
+            return true;
+        }
         
-        status = Stmt(in, line);
-        if (!status) {
-            ParseError(line, "Syntactic error in statement list.");
+        if (!Stmt(in, line, list)) {
             return false;
         }
-        
-        tok = Parser::GetNextToken(in, line);
     }
-    
-    Parser::PushBackToken(tok);
-    return true;
 }
 
 // 8. Stmt ::= AssignStmt | PrintStmts | GetStmt | IfStmt
-bool Stmt(istream& in, int& line) {
-    LexItem tok = Parser::GetNextToken(in, line);
-    
-    //cout << "Current token: " << tok << " at line " << line << endl;  
+bool Stmt(LexSource& in, int& line, vector<StmtNode*>& list) {
+    Token tok = Parser::Peek(in, line).GetToken();
+    StmtNode* stmt = NULL;
+    bool status;
     
     if (tok == PUT || tok == PUTLN) {
-        Parser::PushBackToken(tok);
-        return PrintStmts(in, line);  
+        status = PrintStmts(in, line, stmt);  
     }
     else if (tok == IDENT) {
-        Parser::PushBackToken(tok);
-        return AssignStmt(in, line);  
+        status = AssignStmt(in, line, stmt);  
     }
     else if (tok == GET) {
-        Parser::PushBackToken(tok);
-        return GetStmt(in, line);     
+        status = GetStmt(in, line, stmt);     
     }
     else if (tok == IF) {
-        Parser::PushBackToken(tok);
-        return IfStmt(in, line);      
+        status = IfStmt(in, line, stmt);      
     }
-    
-    //cout << "Unrecognized token: " << tok.GetLexeme() << endl;
-    Parser::PushBackToken(tok);
-    ParseError(line, "Invalid statement: Expected assignment, print, get, or if");
-    return false;
+    else {
+        ParseError(line, "Invalid statement: Expected assignment, print, get, or if");
+        status = false;
+    }
+
+    if (!status) {
+        stmt = prog->NewStmt(S_ERROR, line);
+        stmt->errors = Parser::TakeErrors();
+    }
+    list.push_back(stmt);
+    return status;
 }
 
 // 9. PrintStmts ::= (PutLine | Put) ( Expr) ;
-bool PrintStmts(istream& in, int& line) {
+bool PrintStmts(LexSource& in, int& line, StmtNode*& stmt) {
     LexItem tok = Parser::GetNextToken(in, line);
     
     // Check for PUT or PUTLN
@@ -372,6 +431,8 @@ bool PrintStmts(istream& in, int& line) {
         ParseError(line, "Missing Put or PutLine keyword");
         return false;
     }
+    StmtNode* print = prog->NewStmt(S_PRINT, line);
+    print->newline = isPutln;
 
     // Check for opening parenthesis
     tok = Parser::GetNextToken(in, line);
@@ -380,9 +441,8 @@ bool PrintStmts(istream& in, int& line) {
         return false;
     }
 
-    // Evaluate the expression
-    Value retVal;
-    if (!Expr(in, line, retVal)) {
+    // Parse the expression
+    if (!Expr(in, line, print->expr)) {
         ParseError(line, "Invalid expression in print statement");
         return false;
     }
@@ -400,20 +460,15 @@ bool PrintStmts(istream& in, int& line) {
         ParseError(line, "Missing semicolon at end of statement");
         return false;
     }
+    print->line = line;
 
-    // Perform the actual output
-    if (isPutln) {
-        cout << retVal << endl;  // PUTLN adds newline
-    } else {
-        cout << retVal;         // PUT doesn't add newline
-    }
-
+    stmt = print;
     return true;
 }
 
 // 10. GetStmt := Get (Var) ;
 
-bool GetStmt(istream& in, int& line) {
+bool GetStmt(LexSource& in, int& line, StmtNode*& stmt) {
     LexItem tok;
     LexItem idtok;
     
@@ -436,11 +491,11 @@ bool GetStmt(istream& in, int& line) {
         ParseError(line, "Invalid variable in GET statement");
         return false;
     }
-    string varName = idtok.GetLexeme();
+    int varSym = idtok.GetSymbol();
 
     // 4. Check if variable is declared
-    if (SymTable.find(varName) == SymTable.end()) {
-        ParseError(line, "Undeclared variable: " + varName);
+    if (prog->TypeOf(varSym) == ERR) {
+        ParseError(line, "Undeclared variable: " + idtok.GetLexeme());
         return false;
     }
 
@@ -458,79 +513,76 @@ bool GetStmt(istream& in, int& line) {
         return false;
     }
 
-    // 7. Perform the actual input operation based on variable type
-    Token varType = SymTable[varName];
-    Value inputVal;
-    string inputStr;
-    
-    try {
-        switch(varType) {
-            case INT: {
-                int i;
-                if (!(cin >> i)) {
-                    ParseError(line, "Invalid integer input");
-                    return false;
-                }
-                inputVal = Value(i);
-                break;
-            }
-            case FLOAT: {
-                double d;
-                if (!(cin >> d)) {
-                    ParseError(line, "Invalid float input");
-                    return false;
-                }
-                inputVal = Value(d);
-                break;
-            }
-            case BOOL: {
-                string boolStr;
-                cin >> boolStr;
-                // Convert to lowercase for case-insensitive comparison
-                transform(boolStr.begin(), boolStr.end(), boolStr.begin(), ::tolower);
-                if (boolStr == "true") {
-                    inputVal = Value(true);
-                } else if (boolStr == "false") {
-                    inputVal = Value(false);
-                } else {
-                    ParseError(line, "Invalid boolean input - must be 'true' or 'false'");
-                    return false;
-                }
-                break;
-            }
-            case CHAR: {
-                char c;
-                if (!(cin >> c)) {
-                    ParseError(line, "Invalid character input");
-                    return false;
-                }
-                inputVal = Value(c);
-                break;
-            }
-            case STRING: {
-                getline(cin, inputStr);
-                inputVal = Value(inputStr);
-                break;
-            }
-            default: {
-                ParseError(line, "Invalid type for GET operation");
-                return false;
-            }
+    // 7. The input is read and checked against the variable type when it runs
+    stmt = prog->NewStmt(S_GET, line);
+    stmt->slot = prog->SlotOf(varSym);
+    stmt->type = prog->TypeOf(varSym);
+    return true;
+}
+
+// Statements of one IF branch. A branch that does not parse ends in an S_ERROR
+// and parsing picks up again at the ELSIF, ELSE or END closing it, so that its
+// error is only reported if the branch is taken.
+static bool Branch(LexSource& in, int& line, Span<StmtNode*>& body) {
+    vector<StmtNode*> list;
+    bool status = StmtList(in, line, list);
+    body = prog->Copy(list);
+    if (status) {
+        return true;
+    }
+
+    // the failed statement may have taken the token closing the branch
+    LexItem taken = Parser::tokens.Last();
+    if (taken == ELSIF || taken == ELSE || taken == END) {
+        Parser::PushBackToken();
+    }
+
+    int depth = 0;      // nested IF statements skipped into
+    while (true) {
+        Token tok = Parser::Peek(in, line).GetToken();
+        if ((tok == ELSIF || tok == ELSE || tok == END) && depth == 0) {
+            return true;
+        }
+        // END IF closes the innermost of them
+        if (tok == END && Parser::Peek(in, line, 1) == IF) {
+            Parser::GetNextToken(in, line);
+            Parser::GetNextToken(in, line);
+            depth--;
+            continue;
         }
-    } catch (...) {
-        ParseError(line, "Error during input operation");
+        Parser::GetNextToken(in, line);
+        if (tok == IF) {
+            depth++;
+        }
+        else if (tok == DONE || tok == ERR) {
+            // nowhere to pick up again: the branch error is the IF statement's
+            const Span<SyntaxMsg>& failed = body.back()->errors;
+            Parser::errors.assign(failed.begin(), failed.end());
+            Parser::errors.push_back({failed.back().line, "Syntactic error in statement list."});
+            return false;
+        }
+    }
+}
+
+// ELSIF Expr THEN
+static bool ElsifCondition(LexSource& in, int& line, IfClause& clause) {
+    if (!Expr(in, line, clause.cond)) {
+        ParseError(line, "Missing or invalid condition after ELSIF");
+        return false;
+    }
+    clause.line = line;
+
+    LexItem tok = Parser::GetNextToken(in, line);
+    if (tok != THEN) {
+        ParseError(line, "Missing THEN after ELSIF condition");
         return false;
     }
-    // 8. Store the input value in TempsResults
-    TempsResults[varName] = inputVal;
     return true;
 }
 
 // 11. IfStmt ::= IF Expr THEN StmtList { ELSIF Expr THEN StmtList } [ ELSE StmtList ] END IF ;
-bool IfStmt(istream& in, int& line) {
+bool IfStmt(LexSource& in, int& line, StmtNode*& stmt) {
     LexItem tok;
-    Value condVal;
-    bool conditionMet = false;
     
     // Check IF
     tok = Parser::GetNextToken(in, line);
@@ -538,18 +590,16 @@ bool IfStmt(istream& in, int& line) {
         ParseError(line, "Missing IF keyword");
         return false;
     }
+    StmtNode* ifStmt = prog->NewStmt(S_IF, line);
+    vector<IfClause> clauses(1);
     
-    // Evaluate IF condition
-    if (!Expr(in, line, condVal)) {
+    // IF condition
+    IfClause& first = clauses.back();
+    if (!Expr(in, line, first.cond)) {
         ParseError(line, "Missing or invalid condition after IF");
         return false;
     }
-    
-    // Verify condition is boolean
-    if (!condVal.IsBool()) {
-        ParseError(line, "Run-Time Error-IF condition must be boolean");
-        return false;
-    }
+    first.line = line;
     
     // Check THEN
     tok = Parser::GetNextToken(in, line);
@@ -558,75 +608,26 @@ bool IfStmt(istream& in, int& line) {
         return false;
     }
     
-    // Execute THEN block if condition is true
-    if (condVal.GetBool()) {
-        conditionMet = true;
-        if (!StmtList(in, line)) {
-            return false;
-        }
-    } else {
-        // Skip THEN block by manually finding the next ELSIF, ELSE, or END
-        while (true) {
-            tok = Parser::GetNextToken(in, line);
-            if (tok == ELSIF || tok == ELSE || tok == END) {
-                Parser::PushBackToken(tok);
-                break;
-            }
-            // If we reach the end of file without finding a matching token
-            if (tok == DONE || tok == ERR) {
-                ParseError(line, "Unexpected end of IF statement");
-                return false;
-            }
-        }
+    if (!Branch(in, line, first.body)) {
+        return false;
     }
     
     // Handle ELSIF clauses
     tok = Parser::GetNextToken(in, line);
     while (tok == ELSIF) {
-        // Evaluate ELSIF condition if no previous condition was met
-        if (!conditionMet) {
-            if (!Expr(in, line, condVal)) {
-                ParseError(line, "Missing or invalid condition after ELSIF");
-                return false;
-            }
-            
-            // Verify condition is boolean
-            if (!condVal.IsBool()) {
-                ParseError(line, "Run-Time Error-ELSIF condition must be boolean");
-                return false;
+        clauses.push_back(IfClause());
+        IfClause& clause = clauses.back();
+
+        Parser::tokens.Mark();
+        if (!ElsifCondition(in, line, clause)) {
+            // kept for when the condition is reached; skip it the way it is
+            // skipped once an earlier condition held, from just after ELSIF.
+            // A condition too long to go back over is skipped from where
+            // parsing it stopped.
+            clause.errors = Parser::TakeErrors();
+            if (!Parser::tokens.Reset() && Parser::tokens.Last() == THEN) {
+                Parser::PushBackToken();
             }
-            
-            // Check THEN
-            tok = Parser::GetNextToken(in, line);
-            if (tok != THEN) {
-                ParseError(line, "Missing THEN after ELSIF condition");
-                return false;
-            }
-            
-            // Execute ELSIF block if condition is true
-            if (condVal.GetBool()) {
-                conditionMet = true;
-                if (!StmtList(in, line)) {
-                    return false;
-                }
-            } else {
-                // Skip this ELSIF block
-                while (true) {
-                    tok = Parser::GetNextToken(in, line);
-                    if (tok == ELSIF || tok == ELSE || tok == END) {
-                        Parser::PushBackToken(tok);
-                        break;
-                    }
-                    // If we reach the end of file
-                    if (tok == DONE || tok == ERR) {
-                        ParseError(line, "Unexpected end of IF statement");
-                        return false;
-                    }
-                }
-            }
-        } else {
-            // Skip ELSIF condition and block since a previous condition was met
-            // First skip the condition
             int parenCount = 0;
             while (true) {
                 tok = Parser::GetNextToken(in, line);
@@ -635,50 +636,24 @@ bool IfStmt(istream& in, int& line) {
                 else if (tok == THEN && parenCount == 0) break;
                 // If we reach the end of file
                 if (tok == DONE || tok == ERR) {
-                    ParseError(line, "Unexpected end of IF statement");
-                    return false;
-                }
-            }
-            
-            // Then skip the block
-            while (true) {
-                tok = Parser::GetNextToken(in, line);
-                if (tok == ELSIF || tok == ELSE || tok == END) {
-                    Parser::PushBackToken(tok);
-                    break;
-                }
-                // If we reach the end of file
-                if (tok == DONE || tok == ERR) {
-                    ParseError(line, "Unexpected end of IF statement");
+                    Parser::errors.assign(clause.errors.begin(), clause.errors.end());
                     return false;
                 }
             }
         }
+
+        if (!Branch(in, line, clause.body)) {
+            return false;
+        }
         
         tok = Parser::GetNextToken(in, line);
     }
     
     // Handle ELSE clause
     if (tok == ELSE) {
-        if (!conditionMet) {
-            // Execute ELSE block
-            if (!StmtList(in, line)) {
-                return false;
-            }
-        } else {
-            // Skip ELSE block
-            while (true) {
-                tok = Parser::GetNextToken(in, line);
-                if (tok == END) {
-                    Parser::PushBackToken(tok);
-                    break;
-                }
-                // If we reach the end of file
-                if (tok == DONE || tok == ERR) {
-                    ParseError(line, "Unexpected end of IF statement");
-                    return false;
-                }
-            }
+        clauses.push_back(IfClause());
+        if (!Branch(in, line, clauses.back().body)) {
+            return false;
         }
         
         tok = Parser::GetNextToken(in, line);
@@ -703,18 +678,22 @@ bool IfStmt(istream& in, int& line) {
         return false;
     }
     
+    ifStmt->clauses = prog->Copy(clauses);
+    stmt = ifStmt;
     return true;
 }
 
 // 12. AssignStmt ::= Var := Expr ;
-bool AssignStmt(istream& in, int& line) {
+bool AssignStmt(LexSource& in, int& line, StmtNode*& stmt) {
     // 1. Get the target variable
     LexItem idtok;
     if (!Var(in, line, idtok)) {
         ParseError(line, "Invalid assignment target");
         return false;
     }
-    string varName = idtok.GetLexeme();
+    StmtNode* assign = prog->NewStmt(S_ASSIGN, line);
+    assign->slot = prog->SlotOf(idtok.GetSymbol());
+    assign->type = prog->TypeOf(idtok.GetSymbol());
 
     // 2. Check for assignment operator
     LexItem tok = Parser::GetNextToken(in, line);
@@ -723,57 +702,26 @@ bool AssignStmt(istream& in, int& line) {
         return false;
     }
 
-    // 3. Evaluate the right-hand expression
-    Value rhsVal;
-    if (!Expr(in, line, rhsVal)) {
+    // 3. Parse the right-hand expression; its type is checked when it runs
+    if (!Expr(in, line, assign->expr)) {
         ParseError(line, "Invalid expression in assignment");
         return false;
     }
+    assign->line = line;
 
-    // 4. Verify type compatibility
-    Token varType = SymTable[varName];
-    bool typeError = false;
-    
-    switch(varType) {
-        case INT:
-            if (!rhsVal.IsInt()) typeError = true;
-            break;
-        case FLOAT:
-            if (!rhsVal.IsReal()) typeError = true;
-            break;
-        case BOOL:
-            if (!rhsVal.IsBool()) typeError = true;
-            break;
-        case STRING:
-            if (!rhsVal.IsString()) typeError = true;
-            break;
-        case CHAR:
-            if (!rhsVal.IsChar()) typeError = true;
-            break;
-        default:
-            typeError = true;
-    }
-
-    if (typeError) {
-        ParseError(line, "Type mismatch in assignment");
-        return false;
-    }
-
-    // 5. Store the value
-    TempsResults[varName] = rhsVal;
-
-    // 6. Check for semicolon
+    // 4. Check for semicolon
     tok = Parser::GetNextToken(in, line);
     if (tok != SEMICOL) {
         ParseError(line, "Missing semicolon at end of assignment");
         return false;
     }
 
+    stmt = assign;
     return true;
 }
 
 // 13. Var ::= IDENT
-bool Var(istream& in, int& line, LexItem & idtok) {
+bool Var(LexSource& in, int& line, LexItem & idtok) {
     LexItem tok = Parser::GetNextToken(in, line);
     
     if (tok != IDENT) {
@@ -784,342 +732,220 @@ bool Var(istream& in, int& line, LexItem & idtok) {
     return true;
 }
 
+// Node for left op right
+static ExprNode* Binary(Token op, ExprNode* left, ExprNode* right, int line) {
+    ExprNode* node = prog->NewExpr(E_BINARY, line);
+    node->op = op;
+    node->left = left;
+    node->right = right;
+    return node;
+}
+
 // 14. Expr ::= Relation {(AND | OR) Relation }
-bool Expr(istream& in, int& line, Value & retVal) {
+bool Expr(LexSource& in, int& line, ExprNode*& node) {
     // Get first Relation
-    Value leftVal;
-    if (!Relation(in, line, leftVal)) {
+    ExprNode* left;
+    if (!Relation(in, line, left)) {
         return false;
     }
 
-    LexItem tok;
     while (true) {
-        tok = Parser::GetNextToken(in, line);
+        Token op = Parser::Peek(in, line).GetToken();
         
         // Check for logical operators
-        if (tok != AND && tok != OR) {
-            Parser::PushBackToken(tok);
+        if (op != AND && op != OR) {
             break;
         }
-
-        // Verify left operand is boolean
-        if (!leftVal.IsBool()) {
-            ParseError(line, "Run-Time Error-Left operand of logical operation must be boolean");
-            return false;
-        }
-
-        // Short-circuit evaluation
-        if (tok == AND && leftVal.GetBool() == false) {
-            // Skip evaluating right operand for AND with false
-            Parser::GetNextToken(in, line); // Dummy read to consume the operator
-            Relation(in, line, retVal); // Evaluate but ignore result
-            retVal = Value(false);
-            return true;
-        }
-        if (tok == OR && leftVal.GetBool() == true) {
-            // Skip evaluating right operand for OR with true
-            Parser::GetNextToken(in, line); // Dummy read to consume the operator
-            Relation(in, line, retVal); // Evaluate but ignore result
-            retVal = Value(true);
-            return true;
-        }
+        Parser::GetNextToken(in, line);
+        // The left operand is checked before the right one is evaluated
+        int opLine = line;
 
         // Get right Relation
-        Value rightVal;
-        if (!Relation(in, line, rightVal)) {
+        ExprNode* right;
+        if (!Relation(in, line, right)) {
             ParseError(line, "Missing expression after logical operator");
             return false;
         }
 
-        // Verify right operand is boolean
-        if (!rightVal.IsBool()) {
-            ParseError(line, "Run-Time Error-Right operand of logical operation must be boolean");
-            return false;
-        }
-
-        // Perform the logical operation
-        try {
-            if (tok == AND) {
-                leftVal = leftVal && rightVal;
-            } else {
-                leftVal = leftVal || rightVal;
-            }
-        } catch (...) {
-            ParseError(line, "Run-Time Error-Illegal logical operation");
-            return false;
-        }
+        left = Binary(op, left, right, line);
+        left->line2 = opLine;
     }
 
-    retVal = leftVal;
+    node = left;
     return true;
 }
 
 // 15. Relation ::= SimpleExpr [ ( = | /= | < | <= | > | >= ) SimpleExpr ]
-bool Relation(istream& in, int& line, Value & retVal) {
+bool Relation(LexSource& in, int& line, ExprNode*& node) {
     // Get left SimpleExpr
-    Value leftVal;
-    if (!SimpleExpr(in, line, leftVal)) {
+    ExprNode* left;
+    if (!SimpleExpr(in, line, left)) {
         return false;
     }
 
-    LexItem tok = Parser::GetNextToken(in, line);
+    Token op = Parser::Peek(in, line).GetToken();
     
     // Check if it's a relational operator
-    if (tok != EQ && tok != NEQ && tok != LTHAN && 
-        tok != LTE && tok != GTHAN && tok != GTE) {
-        // Not a relational operator, so just return the SimpleExpr value
-        Parser::PushBackToken(tok);
-        retVal = leftVal;
+    if (op != EQ && op != NEQ && op != LTHAN && 
+        op != LTE && op != GTHAN && op != GTE) {
+        // Not a relational operator, so just return the SimpleExpr
+        node = left;
         return true;
     }
+    Parser::GetNextToken(in, line);
 
     // Get right SimpleExpr
-    Value rightVal;
-    if (!SimpleExpr(in, line, rightVal)) {
+    ExprNode* right;
+    if (!SimpleExpr(in, line, right)) {
         ParseError(line, "Missing expression after relational operator");
         return false;
     }
 
-    // Perform the comparison
-    try {
-        switch (tok.GetToken()) {
-            case EQ:    retVal = leftVal == rightVal; break;
-            case NEQ:   retVal = leftVal != rightVal; break;
-            case LTHAN: retVal = leftVal < rightVal; break;
-            case LTE:   retVal = leftVal <= rightVal; break;
-            case GTHAN: retVal = leftVal > rightVal; break;
-            case GTE:   retVal = leftVal >= rightVal; break;
-            default:
-                ParseError(line, "Invalid relational operator");
-                return false;
-        }
-    } catch (...) {
-        ParseError(line, "Run-Time Error-Illegal operand types for comparison");
-        return false;
-    }
-
+    node = Binary(op, left, right, line);
     return true;
 }
 
 // 16. SimpleExpr ::= STerm { ( + | - | & ) STerm }
-bool SimpleExpr(istream& in, int& line, Value & retVal) {
+bool SimpleExpr(LexSource& in, int& line, ExprNode*& node) {
     // Get first STerm
-    Value leftVal;
-    if (!STerm(in, line, leftVal)) {
+    ExprNode* left;
+    if (!STerm(in, line, left)) {
         ParseError(line, "Missing operand");
         return false;
     }
-    LexItem tok;
     while (true) {
-        tok = Parser::GetNextToken(in, line);   
+        Token op = Parser::Peek(in, line).GetToken();
         // Check for additive operators or concatenation
-        if (tok != PLUS && tok != MINUS && tok != CONCAT) {
-            Parser::PushBackToken(tok);
+        if (op != PLUS && op != MINUS && op != CONCAT) {
             break;
         }
+        Parser::GetNextToken(in, line);
         // Get next STerm
-        Value rightVal;
-        if (!STerm(in, line, rightVal)) {
+        ExprNode* right;
+        if (!STerm(in, line, right)) {
             ParseError(line, "Missing operand after operator");
             return false;
         }
-        // Perform operation based on token type
-        try {
-            if (tok == PLUS) {
-                leftVal = leftVal + rightVal;
-            } 
-            else if (tok == MINUS) {
-                leftVal = leftVal - rightVal;
-            }
-            else if (tok == CONCAT) {
-                leftVal = leftVal.Concat(rightVal);
-            }
-        } 
-        catch (...) {
-            ParseError(line, "Run-Time Error-Illegal operation");
-            return false;
-        }
+        left = Binary(op, left, right, line);
     }
-    retVal = leftVal;
+    node = left;
     return true;
 }
 
 // 17. STerm ::= [ ( + | - ) ] Term
-bool STerm(istream& in, int& line, Value & retVal) {
-    LexItem tok = Parser::GetNextToken(in, line);
+bool STerm(LexSource& in, int& line, ExprNode*& node) {
+    const LexItem& tok = Parser::Peek(in, line);
     int sign = 1; // Default to positive
     
     // Check for unary + or -
     if (tok == PLUS || tok == MINUS) {
         sign = (tok == PLUS) ? 1 : -1;
-    } else {
-        Parser::PushBackToken(tok);
+        Parser::GetNextToken(in, line);
     }
     
-    // Here's where retVal gets populated:
-    if (!Term(in, line, sign, retVal)) { // Term will fill retVal
+    if (!Term(in, line, sign, node)) {
         ParseError(line, "Missing term after unary sign");
         return false;
     }
     
-    // Now we can validate the signed result
-    if (sign != 1) { // Only need to check if sign was applied
-        if (!retVal.IsInt() && !retVal.IsReal()) {
-            ParseError(line, "Run-Time Error-Illegal operand type for sign operation");
-            return false;
-        }
-        
-        // Apply sign if needed (values are already signed from Term/Factor/Primary)
-        // The sign was propagated all the way down to Primary where it was applied
+    // The sign is propagated down to Primary, where a numeric constant takes
+    // it; what is left is to check the signed term is numeric when it runs
+    if (sign != 1) {
+        ExprNode* check = prog->NewExpr(E_SIGN, line);
+        check->left = node;
+        node = check;
     }
     
     return true;
 }
 
 // 18. Term ::= Factor { ( * | / | MOD ) Factor }
-bool Term(istream& in, int& line, int sign, Value & retVal) {
+bool Term(LexSource& in, int& line, int sign, ExprNode*& node) {
     // Get first Factor (with sign applied)
-    Value leftVal;
-    if (!Factor(in, line, sign, leftVal)) {
+    ExprNode* left;
+    if (!Factor(in, line, sign, left)) {
         return false;
     }
 
-    LexItem tok;
     while (true) {
-        tok = Parser::GetNextToken(in, line);
+        Token op = Parser::Peek(in, line).GetToken();
         
         // Check for multiplicative operators
-        if (tok != MULT && tok != DIV && tok != MOD) {
-            Parser::PushBackToken(tok);
+        if (op != MULT && op != DIV && op != MOD) {
             break;
         }
+        Parser::GetNextToken(in, line);
 
         // Get next Factor (sign is 1 since sign only applies to first term)
-        Value rightVal;
-        if (!Factor(in, line, 1, rightVal)) {
+        ExprNode* right;
+        if (!Factor(in, line, 1, right)) {
             ParseError(line, "Missing factor after operator");
             return false;
         }
 
-        // Perform operation based on token type
-        try {
-            if (tok == MULT) {
-                leftVal = leftVal * rightVal;
-            } 
-            else if (tok == DIV) {
-                // Check for division by zero
-                if ((rightVal.IsInt() && rightVal.GetInt() == 0) ||
-                    (rightVal.IsReal() && rightVal.GetReal() == 0.0)) {
-                    ParseError(line, "Run-Time Error-Illegal division by zero");
-                    return false;
-                }
-                leftVal = leftVal / rightVal;
-            } 
-            else if (tok == MOD) {
-                // MOD requires integer operands
-                if (!leftVal.IsInt() || !rightVal.IsInt()) {
-                    ParseError(line, "Run-Time Error-Illegal operand types for MOD");
-                    return false;
-                }
-                // Check for mod by zero
-                if (rightVal.GetInt() == 0) {
-                    ParseError(line, "Run-Time Error-Illegal mod by zero");
-                    return false;
-                }
-                leftVal = leftVal % rightVal;
-            }
-        } catch (...) {
-            ParseError(line, "Run-Time Error-Illegal operation");
-            return false;
-        }
+        left = Binary(op, left, right, line);
     }
 
-    retVal = leftVal;
+    node = left;
     return true;
 }
 
 // 19. Factor ::= Primary [** Primary ] | NOT Primary
-bool Factor(istream& in, int& line, int sign, Value & retVal){
-    LexItem tok = Parser::GetNextToken(in, line);
+bool Factor(LexSource& in, int& line, int sign, ExprNode*& node){
     // CAse 1 NOT Primary
-    if (tok == NOT) {
-        Value primVal;
-        if (!Primary(in, line, 1, primVal)) {  // NOT ignores incoming sign
+    if (Parser::Peek(in, line) == NOT) {
+        Parser::GetNextToken(in, line);
+        ExprNode* prim;
+        if (!Primary(in, line, 1, prim)) {  // NOT ignores incoming sign
             ParseError(line, "Missing primary after NOT");
             return false;
         }
         
-        // Type check - NOT requires boolean operand
-        if (!primVal.IsBool()) {
-            ParseError(line, "Run-Time Error-Illegal operand type for NOT operation");
-            return false;
-        }
-        
-        
-        try {
-            retVal = !primVal;  // Use overloaded ! operator
-        } catch (...) {
-            ParseError(line, "Run-Time Error-Illegal NOT operation");
-            return false;
-        }
+        node = prog->NewExpr(E_NOT, line);
+        node->left = prim;
         return true;
     }        
 
     // Case 2: Primary [** Primary]    
-    Parser::PushBackToken(tok);
-    Value baseVal;
-    if (!Primary(in, line, sign, baseVal)) {
+    ExprNode* base;
+    if (!Primary(in, line, sign, base)) {
         ParseError(line, "Missing primary");
         return false;
     }
     
-    tok = Parser::GetNextToken(in, line);
-    if (tok == EXP) {
-        Value expVal;
-        LexItem signTok = Parser::GetNextToken(in, line);
+    if (Parser::Peek(in, line) == EXP) {
+        Parser::GetNextToken(in, line);
+        ExprNode* exp;
+        const LexItem& signTok = Parser::Peek(in, line);
         int expSign = 1;
         
-        if (signTok == PLUS) {
-            expSign = 1;
-        } else if (signTok == MINUS) {
-            expSign = -1;
-        } else {
-            Parser::PushBackToken(signTok);
+        if (signTok == PLUS || signTok == MINUS) {
+            expSign = (signTok == PLUS) ? 1 : -1;
+            Parser::GetNextToken(in, line);
         }
         
-        if (!Primary(in, line, expSign, expVal)) {
+        if (!Primary(in, line, expSign, exp)) {
             ParseError(line, "Missing exponent after **");
             return false;
         }
         
-        // Type checking - both operands must be real for exponentiation
-        if (!baseVal.IsReal() || !expVal.IsReal()) {
-            ParseError(line, "Run-Time Error-Exponentiation requires float operands");
-            return false;
-        }
-        
-        try {
-            retVal = baseVal.Exp(expVal);  // Use the Exp member function
-        } catch (...) {
-            ParseError(line, "Run-Time Error-Illegal exponentiation operation");
-            return false;
-        }
+        node = Binary(EXP, base, exp, line);
     } 
     else {
-        Parser::PushBackToken(tok);
-        retVal = baseVal;  // No exponentiation, just return the primary
+        node = base;  // No exponentiation, just return the primary
     }
     
     return true;
 }
 
 // 20. Primary ::= Name | ICONST | FCONST | SCONST | BCONST | CCONST | (Expr)
-bool Primary(istream& in, int& line, int sign, Value & retVal) {
+bool Primary(LexSource& in, int& line, int sign, ExprNode*& node) {
     LexItem tok = Parser::GetNextToken(in, line);
     
     // Parenthesized expressions
     if (tok == LPAREN) {
-        if (!Expr(in, line, retVal)) {
+        ExprNode* inner;
+        if (!Expr(in, line, inner)) {
             ParseError(line, "Invalid expression in parentheses");
             return false;
         }
@@ -1128,92 +954,79 @@ bool Primary(istream& in, int& line, int sign, Value & retVal) {
             ParseError(line, "Missing right parenthesis");
             return false;
         }
+        node = prog->NewExpr(E_PAREN, line);
+        node->left = inner;
         return true;
     }
     // Variables (delegate to Name)
     if (tok == IDENT) {
-        Parser::PushBackToken(tok);
-        return Name(in, line, sign, retVal);
+        Parser::PushBackToken();
+        return Name(in, line, sign, node);
     }
     // Literals
-    if (tok == ICONST) {
-        retVal = Value(stoi(tok.GetLexeme()) * sign);
-        return true;
-    }
-    if (tok == FCONST) {
-        retVal = Value(stod(tok.GetLexeme()) * sign);
-        return true;
-    }
-    if (tok == SCONST) {
-        retVal = Value(tok.GetLexeme());
+    if (tok == ICONST || tok == FCONST || tok == SCONST || tok == CCONST || tok == BCONST) {
+        node = prog->NewExpr(E_CONST, line);
+        if (tok == ICONST) {
+            node->vtype = VINT;
+            node->ival = tok.GetIntValue() * sign;
+        }
+        else if (tok == FCONST) {
+            node->vtype = VREAL;
+            node->rval = tok.GetRealValue() * sign;
+        }
+        else if (tok == SCONST) {
+            node->vtype = VSTRING;
+            node->text = prog->Text(tok.Text());
+            node->slen = tok.Text().size();
+        }
+        else if (tok == CCONST) {
+            node->vtype = VCHAR;
+            node->cval = tok.Text()[0];
+        }
+        else {
+            node->vtype = VBOOL;
+            node->bval = tok.Text() == "true";
+        }
         return true;
     }
-    if (tok == CCONST) {
-        retVal = Value(tok.GetLexeme()[0]);
-        return true;
+    // Constants the lexer found too big; any other lexical error is just
+    // an invalid primary, as it always was
+    if (tok.OutOfRange()) {
+        ParseError(line, "Lexical error {" + tok.GetLexeme() + "}");
+        return false;
     }
-    if (tok == BCONST) {
-        retVal = Value(tok.GetLexeme() == "true");
-        return true;
-    }   
     ParseError(line, "Invalid primary expression");
     return false;
 }
 
 // 21. Name ::= IDENT [ ( Range ) ]
-bool Name(istream& in, int& line, int sign, Value & retVal) {
+bool Name(LexSource& in, int& line, int sign, ExprNode*& node) {
     LexItem tok = Parser::GetNextToken(in, line);
     if (tok != IDENT) {
         ParseError(line, "Expected an identifier");
         return false;
     }
-    //we will need the varName to look it up in our tables
-    string varName = tok.GetLexeme();
+    //we will need the symbol id to find its frame slot
+    int varSym = tok.GetSymbol();
 
     // Check if variable is declared 
-    if (SymTable.find(varName) == SymTable.end()) {
-        ParseError(line, "Undeclared variable: " + varName);
+    if (prog->TypeOf(varSym) == ERR) {
+        ParseError(line, "Undeclared variable: " + tok.GetLexeme());
         return false;
     }
     
-    // Check if variable is initialized
-    if (TempsResults.find(varName) == TempsResults.end()) {
-        ParseError(line, "Uninitialized variable: " + varName);
-        return false;
-    }
-
-    retVal = TempsResults[varName];
-
-    tok = Parser::GetNextToken(in, line);
-    if (tok == LPAREN) {
-        Value startIdx, endIdx;
-        if (!Range(in, line, startIdx, endIdx)){
+    // Whether it is initialized is checked when it runs
+    ExprNode* var = prog->NewExpr(E_VAR, line);
+    var->slot = prog->SlotOf(varSym);
+
+    if (Parser::Peek(in, line) == LPAREN) {
+        Parser::GetNextToken(in, line);
+        node = prog->NewExpr(E_INDEX, line);
+        node->left = var;
+        if (!Range(in, line, node)){
             return false;
         } 
 
-        //at this point the range is valid so we need to actually substring here
-        if(!retVal.IsString()){
-            ParseError(line,"Not a string");
-        }
-
-        string retValstr = retVal.GetString();
-        int len = retValstr.length();
-        int start = startIdx.GetInt();
-        if (endIdx.IsInt()) {  // Substring access
-            int end = endIdx.GetInt();
-            if (start < 0 || end >= len || start > end) {
-                ParseError(line, "String index out of bounds");
-                return false;
-            }
-            retVal.SetString(retValstr.substr(start, end - start + 1));
-        } else {  
-            if (start < 0 || start >= len) {
-                ParseError(line, "String index out of bounds");
-                return false;
-            }
-                retVal = Value(retValstr[start]);
-        }
-
         tok = Parser::GetNextToken(in, line);
         if (tok != RPAREN) {
             ParseError(line, "Missing closing parenthesis for range");
@@ -1221,57 +1034,37 @@ bool Name(istream& in, int& line, int sign, Value & retVal) {
         }
     } 
     else {
-        Parser::PushBackToken(tok);
+        node = var;
     }
     return true;
 }
 
 // 22. Range ::= SimpleExpr [. . SimpleExpr ]
-bool Range(istream& in, int& line, Value & retVal1, Value & retVal2) {
+// The indices of node, whose bounds are checked when it runs
+bool Range(LexSource& in, int& line, ExprNode* node) {
     // Parse first SimpleExpr (start index)
-    if (!SimpleExpr(in, line, retVal1)) {
+    if (!SimpleExpr(in, line, node->right)) {
         ParseError(line, "Missing start index in range");
         return false;
     }
+    node->line2 = line;
 
-    // Check if first value is integer (required for indexing)
-    if (!retVal1.IsInt()) {
-        ParseError(line, "Range indices must be integers");
-        return false;
-    }
-
-    LexItem tok = Parser::GetNextToken(in, line);
-    
     // Check for range operator (..)
-    if (tok == DOT) {
-        tok = Parser::GetNextToken(in, line);
+    if (Parser::Peek(in, line) == DOT) {
+        Parser::GetNextToken(in, line);
+        LexItem tok = Parser::GetNextToken(in, line);
         if (tok != DOT) {
             ParseError(line, "Missing second dot in range operator");
             return false;
         }
 
         // Parse second SimpleExpr (end index)
-        if (!SimpleExpr(in, line, retVal2)) {
+        if (!SimpleExpr(in, line, node->hi)) {
             ParseError(line, "Missing end index in range");
             return false;
         }
-
-        // Check if second value is integer
-        if (!retVal2.IsInt()) {
-            ParseError(line, "Range indices must be integers");
-            return false;
-        }
-
-        // Validate range (start <= end)
-        if (retVal1.GetInt() > retVal2.GetInt()) {
-            ParseError(line, "Invalid range - start index > end index");
-            return false;
-        }
-    } 
-    else {
-        Parser::PushBackToken(tok);
-        retVal2.SetType(VERR); // Mark as no second value
     }
+    node->line = line;
 
     return true;
-}
\ No newline at end of file
+}
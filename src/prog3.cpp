@@ -8,12 +8,154 @@
 
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstdlib>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 
 #include "parserInterp.h"
+#include "bytecode.h"
+#include "srcfile.h"
+#include "interp.h"
+#include "codecache.h"
+#include "emitcpp.h"
+#include "jit.h"
 
 
 using namespace std;
+using namespace std::chrono;
+
+//One program of a batch and what running it printed
+struct BatchJob {
+	string	prog;
+	string	input;		//empty: no input
+	string	out;
+	string	err;
+	double	secs;
+	bool	done;
+};
+
+//run job as this driver runs a single file, with its output captured
+static void RunJob(Interpreter& interp, BatchJob& job)
+{
+	auto t0 = steady_clock::now();
+	ostringstream out, err;
+
+	//a regular file is mapped, anything else read whole
+	SourceFile src;
+	string text;
+	bool found = src.Open(job.prog);
+	if( !found ) {
+		ifstream file(job.prog.c_str());
+		stringstream ss;
+		ss << file.rdbuf();
+		text = ss.str();
+		found = file.is_open();
+	}
+	const char* data = found && text.empty() ? src.Data() : text.data();
+	size_t size = found && text.empty() ? src.Size() : text.size();
+
+	ifstream file;
+	istringstream none;
+	if( !job.input.empty() )
+		file.open(job.input.c_str());
+
+	if( !found )
+		err << "CANNOT OPEN " << job.prog << endl;
+	else if( !job.input.empty() && !file.is_open() )
+		err << "CANNOT OPEN " << job.input << endl;
+	else {
+		istream& in = job.input.empty() ? (istream&) none : file;
+		if( !interp.Run(data, size, in, out, err) )
+			out << "\nUnsuccessful Interpretation " << endl << "Number of Errors " << interp.ErrCount() << endl;
+		else
+			out << "\nSuccessful Execution" << endl;
+	}
+
+	job.out = out.str();
+	job.err = err.str();
+	job.secs = duration<double>(steady_clock::now() - t0).count();
+}
+
+//Run the programs listed in the file list, one per line with the file of its
+//input after it, if any, on a pool of threads with an interpreter each. The
+//output of each is printed under its name in the order of the list, as soon
+//as it and those before it are done; what it printed to the standard error
+//likewise. The throughput and latencies go to the standard error at the end.
+static int RunBatch(const string& list, Interpreter::Engine engine, unsigned threads)
+{
+	ifstream file(list.c_str());
+	if( !file.is_open() ) {
+		cerr << "CANNOT OPEN " << list << endl;
+		return 0;
+	}
+	vector<BatchJob> jobs;
+	string line;
+	while( getline(file, line) ) {
+		istringstream fields(line);
+		BatchJob job = BatchJob();
+		if( fields >> job.prog ) {
+			fields >> job.input;
+			jobs.push_back(job);
+		}
+	}
+	if( threads == 0 )
+		threads = max(1u, thread::hardware_concurrency());
+	threads = min<size_t>(threads, max<size_t>(jobs.size(), 1));
+
+	mutex lock;
+	condition_variable ready;
+	atomic<size_t> next(0);
+	auto t0 = steady_clock::now();
+
+	vector<thread> pool;
+	for( unsigned t = 0; t < threads; t++ ) {
+		pool.emplace_back([&] {
+			Interpreter interp(engine);
+			for( size_t i; (i = next++) < jobs.size(); ) {
+				RunJob(interp, jobs[i]);
+				lock_guard<mutex> hold(lock);
+				jobs[i].done = true;
+				ready.notify_all();
+			}
+		});
+	}
+
+	vector<double> secs;
+	for( BatchJob& job : jobs ) {
+		{
+			unique_lock<mutex> hold(lock);
+			ready.wait(hold, [&] { return job.done; });
+		}
+		cout << "==> " << job.prog << " <==" << endl << job.out;
+		if( !job.err.empty() )
+			cerr << "==> " << job.prog << " <==" << endl << job.err;
+		secs.push_back(job.secs);
+		string().swap(job.out);
+		string().swap(job.err);
+	}
+	for( thread& t : pool )
+		t.join();
+	double wall = duration<double>(steady_clock::now() - t0).count();
+
+	sort(secs.begin(), secs.end());
+	auto percentile = [&](double p) {
+		return secs.empty() ? 0.0 : secs[min(secs.size() - 1, (size_t) (p * secs.size()))] * 1e3;
+	};
+	cout.flush();
+	cerr << "batch: " << jobs.size() << " programs in " << fixed << setprecision(3) << wall << " s on "
+		<< threads << " threads, " << setprecision(1) << jobs.size() / wall << " programs/s" << endl;
+	cerr << "latency: p50 " << setprecision(3) << percentile(0.50) << " ms, p90 " << percentile(0.90)
+		<< " ms, p99 " << percentile(0.99) << " ms, max " << percentile(1.0) << " ms" << endl;
+	return 0;
+}
 
 int main(int argc, char *argv[])
 {
@@ -21,16 +163,75 @@ int main(int argc, char *argv[])
 
 	istream *in = NULL;
 	ifstream file;
+	SourceFile src;
+	bool mapped = false;
+	bool stats = false;
+	string engine = "tree";
+	bool engineGiven = false;
+	string batch;
+	unsigned threads = 0;
+	bool cache = false;
+	string cacheDir;
+	bool emit = false;
+	string emitPath;
+	string name;
 		
 	for( int i=1; i<argc; i++ )
     {
 		string arg = argv[i];
 		
-		if( in != NULL ) 
+		if( arg == "--arena-stats" )
+		{
+			//report how the program's syntax tree used its arena
+			stats = true;
+		}
+		else if( arg.compare(0, 9, "--engine=") == 0 )
+		{
+			//tree: walk the syntax tree; vm: compile it to bytecode and run that;
+			//jit: compile the bytecode on to machine code, where there is a JIT
+			engine = arg.substr(9);
+			engineGiven = true;
+			if( engine != "tree" && engine != "vm" && engine != "jit" )
+			{
+				cerr << "UNRECOGNIZED ENGINE " << engine << endl;
+				return 0;
+			}
+		}
+		else if( arg.compare(0, 8, "--batch=") == 0 )
+		{
+			//run every program the file lists, on several threads
+			batch = arg.substr(8);
+		}
+		else if( arg.compare(0, 10, "--threads=") == 0 )
+		{
+			//threads of a batch; 0, the default, is one per core
+			threads = atoi(arg.substr(10).c_str());
+		}
+		else if( arg == "--cache" || arg.compare(0, 8, "--cache=") == 0 )
+		{
+			//run the bytecode kept from an earlier run of the same source, or
+			//keep it for the next: next to the source, or in an existing directory
+			cache = true;
+			cacheDir = arg.substr(min<size_t>(arg.length(), 8));
+		}
+		else if( arg == "--emit-cpp" || arg.compare(0, 11, "--emit-cpp=") == 0 )
+		{
+			//write the program out as C++ instead of running it: on the
+			//standard output, or to the file named
+			emit = true;
+			emitPath = arg.substr(min<size_t>(arg.length(), 11));
+		}
+		else if( in != NULL || mapped ) 
         {
 			cerr << "ONLY ONE FILE NAME ALLOWED" << endl;
 			return 0;
 		}
+		else if( src.Open(arg) )
+		{
+			//regular file: lex straight out of the mapped buffer
+			mapped = true;
+			name = arg;
+		}
 		else 
         {
 			file.open(arg.c_str());
@@ -41,15 +242,103 @@ int main(int argc, char *argv[])
 			}
 
 			in = &file;
+			name = arg;
 		}
 	}
-    if(argc == 1)
+	//a batch runs each program on an interpreter of its own, which neither
+	//keeps its bytecode nor writes it out
+	if( !batch.empty() && (cache || emit) )
+	{
+		cerr << "--batch RUNS WITHOUT --cache OR --emit-cpp" << endl;
+		return 0;
+	}
+	if( !batch.empty() )
+		return RunBatch(batch, engine == "vm" ? Interpreter::VM : engine == "jit" ? Interpreter::JIT : Interpreter::TREE,
+			threads);
+    if( in == NULL && !mapped )
 	{
 		cerr << "Missing File Name." << endl;
 		return 0;
 	}
 	
-    bool status = Prog(*in, lineNumber);
+	//the cache holds bytecode, so a cached run is a run on the vm engine, or
+	//the jit one compiling it further; only a regular file, hashed whole, is
+	//looked up
+	if( cache && engineGiven && engine == "tree" )
+	{
+		cerr << "--cache RUNS THE VM OR JIT ENGINE ONLY" << endl;
+		return 0;
+	}
+	if( cache && !mapped )
+	{
+		cerr << "--cache NEEDS A REGULAR FILE" << endl;
+		return 0;
+	}
+	CachedCode cached;
+	string cachePath;
+	uint64_t hash = 0;
+	if( cache ) {
+		if( engine == "tree" )
+			engine = "vm";
+		hash = SourceHash(src.Data(), src.Size());
+		if( cacheDir.empty() )
+			cachePath = name + ".sadc";
+		else {
+			ostringstream key;
+			key << cacheDir << "/" << hex << setw(16) << setfill('0') << hash << ".sadc";
+			cachePath = key.str();
+		}
+	}
+
+	//a mapped file is lexed in one pass up front (on several threads when it is
+	//large) and parsed from the token buffer; anything else (a pipe, a
+	//terminal) is read and lexed a block at a time. A cache file that is good
+	//for the source saves all of it.
+	Program program;
+	Interner names;
+	bool hit = !cachePath.empty() && cached.Load(cachePath, hash, src.Size());
+	if( !hit && mapped ) {
+		TokenBuffer toks;
+		LexBuffer buf(src.Data(), src.Size(), &names);
+		int lexLine = lineNumber;
+		toks.LexParallel(buf, lexLine);
+		LexSource lexsrc(toks);
+		Parse(lexsrc, lineNumber, program);
+	}
+	else if( !hit ) {
+		LexStream strm(*in, &names);
+		LexSource lexsrc(strm);
+		Parse(lexsrc, lineNumber, program);
+	}
+	if( emit ) {
+		Code code;
+		if( !hit )
+			Compile(program, code);
+		ofstream cppFile;
+		if( !emitPath.empty() ) {
+			cppFile.open(emitPath.c_str());
+			if( !cppFile.is_open() ) {
+				cerr << "CANNOT OPEN " << emitPath << endl;
+				return 0;
+			}
+		}
+		EmitCpp(hit ? cached.code : code, name,
+			emitPath.empty() ? cout : cppFile);
+		return 0;
+	}
+
+	bool status;
+	if( hit )
+		status = engine == "jit" ? RunNative(cached.code) : Run(cached.code);
+	else if( engine != "tree" ) {
+		Code code;
+		Compile(program, code);
+		if( !cachePath.empty() )
+			SaveCode(code, hash, src.Size(), cachePath);
+		status = engine == "jit" ? RunNative(code) : Run(code);
+	}
+	else
+		status = Execute(program);
     
     if( !status ){
     	cout << "\nUnsuccessful Interpretation " << endl << "Number of Errors " << ErrCount()  << endl;
@@ -57,4 +346,11 @@ int main(int argc, char *argv[])
 	else{
 		cout << "\nSuccessful Execution" << endl;
 	}
+
+	if( stats ) {
+		Arena::Stats mem = program.MemoryStats();
+		cerr << "Arena: " << mem.used << " bytes used in " << mem.blocks << " blocks, "
+			<< mem.reserved << " reserved, " << fixed << setprecision(2)
+			<< mem.Fragmentation() * 100 << "% fragmentation" << endl;
+	}
 }
@@ -0,0 +1,137 @@
+/*
+ * runtime.cpp
+ * Run-time support shared by the tree evaluator and the bytecode VM
+ * CS280 - Spring 2025
+ */
+
+#include <algorithm>
+
+#include "parserInterp.h"
+#include "runtime.h"
+
+// errors of the last run that ended on this thread
+static thread_local int lastErrors = 0;
+
+int ErrCount()
+{
+	return lastErrors;
+}
+
+Runtime::Runtime(istream& in, ostream& out, ostream& err)
+	: in(in), out(out), errors(0), errLine(0), valueErrors(ValueErrors)
+{
+	ValueErrors = &err;
+}
+
+Runtime::~Runtime()
+{
+	ValueErrors = valueErrors;
+	lastErrors = errors;
+}
+
+void RunError(Runtime& rt, int line, const string& msg)
+{
+	++rt.errors;
+	rt.errLine = line;
+	rt.out << line << ": " << msg << endl;
+}
+
+bool OfType(Token type, const Value& val) {
+    switch(type) {
+        case INT:    return val.IsInt();
+        case FLOAT:  return val.IsReal();
+        case BOOL:   return val.IsBool();
+        case STRING: return val.IsString();
+        case CHAR:   return val.IsChar();
+        default:     return false;
+    }
+}
+
+bool ReadInput(Runtime& rt, Token type, int line, Value& inputVal) {
+    string inputStr;
+
+    try {
+        switch(type) {
+            case INT: {
+                int i;
+                if (!(rt.in >> i)) {
+                    RunError(rt, line, "Invalid integer input");
+                    return false;
+                }
+                inputVal = Value(i);
+                break;
+            }
+            case FLOAT: {
+                double d;
+                if (!(rt.in >> d)) {
+                    RunError(rt, line, "Invalid float input");
+                    return false;
+                }
+                inputVal = Value(d);
+                break;
+            }
+            case BOOL: {
+                string boolStr;
+                rt.in >> boolStr;
+                // Convert to lowercase for case-insensitive comparison
+                transform(boolStr.begin(), boolStr.end(), boolStr.begin(), ::tolower);
+                if (boolStr == "true") {
+                    inputVal = Value(true);
+                } else if (boolStr == "false") {
+                    inputVal = Value(false);
+                } else {
+                    RunError(rt, line, "Invalid boolean input - must be 'true' or 'false'");
+                    return false;
+                }
+                break;
+            }
+            case CHAR: {
+                char c;
+                if (!(rt.in >> c)) {
+                    RunError(rt, line, "Invalid character input");
+                    return false;
+                }
+                inputVal = Value(c);
+                break;
+            }
+            case STRING: {
+                getline(rt.in, inputStr);
+                inputVal = Value(inputStr);
+                break;
+            }
+            default: {
+                RunError(rt, line, "Invalid type for GET operation");
+                return false;
+            }
+        }
+    } catch (...) {
+        RunError(rt, line, "Error during input operation");
+        return false;
+    }
+    return true;
+}
+
+bool Substring(Runtime& rt, Value& retVal, int start, const Value* endIdx, int line) {
+    if (!retVal.IsString()) {
+        RunError(rt, line, "Not a string");
+        return false;
+    }
+
+    string retValstr = retVal.GetString();
+    int len = retValstr.length();
+    if (endIdx != NULL) {  // Substring access
+        int end = endIdx->GetInt();
+        if (start < 0 || end >= len || start > end) {
+            RunError(rt, line, "String index out of bounds");
+            return false;
+        }
+        retVal.SetString(retValstr.substr(start, end - start + 1));
+    } else {
+        if (start < 0 || start >= len) {
+            RunError(rt, line, "String index out of bounds");
+            return false;
+        }
+        retVal = Value(retValstr[start]);
+    }
+    return true;
+}
@@ -0,0 +1,84 @@
+/*
+ * srcfile.cpp
+ * Whole-file source access for the SADAL lexer
+ * CS280 - Spring 2025
+ */
+
+#include <fstream>
+#include <sstream>
+
+#include "srcfile.h"
+
+#if defined(_WIN32)
+
+bool SourceFile::Open(const string& name)
+{
+	Close();
+	ifstream file(name.c_str(), ios::in | ios::binary);
+	if( !file.is_open() )
+		return false;
+
+	ostringstream ss;
+	ss << file.rdbuf();
+	copy = ss.str();
+	data = copy.data();
+	size = copy.size();
+	return true;
+}
+
+void SourceFile::Close()
+{
+	copy.clear();
+	data = "";
+	size = 0;
+}
+
+#else
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+bool SourceFile::Open(const string& name)
+{
+	Close();
+	//opening a FIFO would wait for a writer, and the caller reads it as a
+	//stream anyway, so only a regular file is opened here
+	struct stat st;
+	if( stat(name.c_str(), &st) != 0 || !S_ISREG(st.st_mode) )
+		return false;
+
+	int fd = open(name.c_str(), O_RDONLY);
+	if( fd < 0 )
+		return false;
+	if( fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) ) {
+		close(fd);
+		return false;
+	}
+
+	if( st.st_size > 0 ) {
+		void* addr = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if( addr == MAP_FAILED ) {
+			close(fd);
+			return false;
+		}
+		madvise(addr, st.st_size, MADV_SEQUENTIAL);
+		data = (const char*) addr;
+		size = st.st_size;
+		mapped = true;
+	}
+	close(fd);
+	return true;
+}
+
+void SourceFile::Close()
+{
+	if( mapped )
+		munmap((void*) data, size);
+	mapped = false;
+	data = "";
+	size = 0;
+}
+
+#endif
@@ -0,0 +1,153 @@
+/*
+ * tokbuf.cpp
+ * Pre-tokenized program text for the SADAL parser
+ * CS280 - Spring 2025
+ */
+
+#include <thread>
+
+#include "lex.h"
+#include "lexscan.h"
+
+void TokenBuffer::Add(const LexItem& tok)
+{
+	items.push_back(tok);
+}
+
+void TokenBuffer::Lex(istream& in, int& linenum, Interner& names)
+{
+	LexItem tok;
+	do {
+		tok = getNextToken(in, linenum, names, pool);
+		Add(tok);
+	} while( tok != DONE );
+}
+
+void TokenBuffer::Lex(LexBuffer& buf, int& linenum)
+{
+	//most programs run about one token per four bytes of source
+	items.reserve((buf.end - buf.cur) / 4 + 16);
+
+	LexBuffer scan(buf);
+	scan.pool = &pool;
+	LexItem tok;
+	do {
+		tok = getNextToken(scan, linenum);
+		Add(tok);
+	} while( tok != DONE );
+	buf.cur = scan.cur;
+}
+
+//One stretch of the source lexed on its own thread. Line numbers count from 0 at
+//the stretch's start and identifiers go to a private interner; Append rebases both.
+struct TokenBuffer::Chunk {
+	const char*	from;		//where lexing of this stretch started
+	const char*	limit;		//tokens starting at or past here belong to the next chunk
+	const char*	first;		//start of its first token
+	const char*	stop;		//start of the token after its last one
+	int	firstLine;		//line at first, counted from from
+	int	stopLine;		//line at stop, counted from from
+	TokenBuffer	toks;
+	Interner	names;
+};
+
+void TokenBuffer::LexChunk(Chunk& c, const char* from, const char* limit, const char* end)
+{
+	c.toks = TokenBuffer();
+	c.names = Interner();
+	LexBuffer buf(from, end - from, &c.names, &c.toks.pool);
+	int line = 0;
+
+	c.from = from;
+	SkipBlanks(buf, line);
+	c.first = buf.cur;
+	c.firstLine = line;
+
+	//a token may run past limit (the scanner always sees the real end of the
+	//source), but none starts there unless this is the last chunk
+	while( buf.cur < limit || limit == end ) {
+		LexItem tok = getNextToken(buf, line);
+		c.toks.Add(tok);
+		if( tok == DONE )
+			break;
+		SkipBlanks(buf, line);
+	}
+	c.stop = buf.cur;
+	c.stopLine = line;
+}
+
+void TokenBuffer::Append(TokenBuffer& part, int lineBase, const Interner& partNames, Interner& names)
+{
+	vector<int> ids(partNames.Size(), -1);
+
+	for( size_t i = 0; i < part.Size(); i++ ) {
+		LexItem tok = part.items[i];
+		tok.lnum += lineBase;
+		if( tok == IDENT ) {
+			int sym = tok.GetSymbol();
+			if( ids[sym] < 0 )
+				ids[sym] = names.Intern(partNames.Name(sym));
+			tok = IdentItem(ids[sym], names, tok.lnum);
+		}
+		items.push_back(tok);
+	}
+	//the tokens' text now lives as long as this buffer
+	pool.Adopt(part.pool);
+}
+
+void TokenBuffer::LexParallel(LexBuffer& buf, int& linenum, unsigned threads)
+{
+	//below a few hundred KB per thread starting threads costs more than it saves
+	size_t len = buf.end - buf.cur;
+	if( threads == 0 )
+		threads = min<size_t>(thread::hardware_concurrency(), len / (256 * 1024));
+	if( threads <= 1 ) {
+		Lex(buf, linenum);
+		return;
+	}
+
+	//cut at line starts: a comment never spans one, and a string or character
+	//constant only does when it is malformed, which the stitch below catches
+	vector<const char*> cuts(1, buf.cur);
+	for( unsigned k = 1; k < threads; k++ ) {
+		const char* p = FindNewline(buf.cur + len * k / threads, buf.end);
+		if( p + 1 < buf.end && p + 1 > cuts.back() )
+			cuts.push_back(p + 1);
+	}
+	cuts.push_back(buf.end);
+
+	size_t nchunks = cuts.size() - 1;
+	vector<Chunk> chunks(nchunks);
+	vector<thread> workers;
+	for( size_t k = 1; k < nchunks; k++ )
+		workers.emplace_back(LexChunk, ref(chunks[k]), cuts[k], cuts[k + 1], buf.end);
+	LexChunk(chunks[0], cuts[0], cuts[1], buf.end);
+	for( size_t k = 0; k < workers.size(); k++ )
+		workers[k].join();
+
+	//Chunks join up when the next one's first token starts where the previous
+	//one stopped: from the same position the scanner makes the same tokens.
+	//A chunk that began inside a token of its predecessor is lexed again from
+	//where that predecessor really stopped.
+	size_t total = Size();
+	for( size_t k = 0; k < nchunks; k++ )
+		total += chunks[k].toks.Size();
+	items.reserve(total);
+
+	int line = linenum;
+	for( size_t k = 0; k < nchunks; k++ ) {
+		Chunk& c = chunks[k];
+		if( k > 0 ) {
+			const Chunk& prev = chunks[k - 1];
+			if( c.first != prev.stop )
+				LexChunk(c, prev.stop, cuts[k + 1], buf.end);
+		}
+		int base = k == 0 ? linenum : line - c.firstLine;
+		Append(c.toks, base, c.names, *buf.names);
+		line = base + c.stopLine;
+		if( c.toks.Size() > 0 && c.toks.items.back() == DONE )
+			break;
+	}
+	buf.cur = buf.end;
+	linenum = line;
+}
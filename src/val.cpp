@@ -3,6 +3,8 @@
 #include <cmath>
 
 
+thread_local ostream* ValueErrors = &cerr;
+
 // Arithmetic Operators
 
 
@@ -12,7 +14,7 @@ Value Value::operator+(const Value& op) const {
     if (IsReal() && op.IsReal())
         return Value(GetReal() + op.GetReal());
 
-    cerr << "Run-Time Error: Illegal operands for +" << endl;
+    *ValueErrors << "Run-Time Error: Illegal operands for +" << endl;
     return Value();  
 }
 
@@ -24,7 +26,7 @@ Value Value::operator-(const Value& op) const {
         return Value(GetReal() - op.GetReal());
     }
     
-    cerr << "Run-Time Error: Illegal operands for -" << endl;
+    *ValueErrors << "Run-Time Error: Illegal operands for -" << endl;
     return Value();
 }
 
@@ -36,38 +38,38 @@ Value Value::operator*(const Value& op) const {
         return Value(GetReal() * op.GetReal());
     }
     
-    cerr << "Run-Time Error: Illegal operands for *" << endl;
+    *ValueErrors << "Run-Time Error: Illegal operands for *" << endl;
     return Value();
 }
 
 Value Value::operator/(const Value& op) const {
     if (IsInt() && op.IsInt()) {
         if (op.GetInt() == 0) {
-            cerr << "Run-Time Error: Division by zero" << endl;
+            *ValueErrors << "Run-Time Error: Division by zero" << endl;
             return Value();
         }
         return Value(GetInt() / op.GetInt());
     }
     if (IsReal() && op.IsReal()) {
         if (op.GetReal() == 0.0) {
-            cerr << "Run-Time Error: Division by zero" << endl;
+            *ValueErrors << "Run-Time Error: Division by zero" << endl;
             return Value();
         }
         return Value(GetReal() / op.GetReal());
     }
-    cerr << "Run-Time Error: Illegal operands for /" << endl;
+    *ValueErrors << "Run-Time Error: Illegal operands for /" << endl;
     return Value();
 }
 
 Value Value::operator%(const Value& op) const {
     if (IsInt() && op.IsInt()) {
         if (op.GetInt() == 0) {
-            cerr << "Run-Time Error: Division by zero" << endl;
+            *ValueErrors << "Run-Time Error: Division by zero" << endl;
             return Value();
         }
         return Value(GetInt() % op.GetInt());
     }
-    cerr << "Run-Time Error: Illegal operands for %" << endl;
+    *ValueErrors << "Run-Time Error: Illegal operands for %" << endl;
     return Value();
 }
 
@@ -86,7 +88,7 @@ Value Value::operator==(const Value& op) const {
     if (IsString() && op.IsString())
         return Value(GetString() == op.GetString());
     
-    cerr << "Run-Time Error: Illegal operands for ==" << endl;
+    *ValueErrors << "Run-Time Error: Illegal operands for ==" << endl;
     return Value();
 }
 
@@ -102,7 +104,7 @@ Value Value::operator!=(const Value& op) const {
     if (IsString() && op.IsString())
         return Value(GetString() != op.GetString());
     
-    cerr << "Run-Time Error: Illegal operands for !=" << endl;
+    *ValueErrors << "Run-Time Error: Illegal operands for !=" << endl;
     return Value();
 }
 
@@ -116,7 +118,7 @@ Value Value::operator>(const Value& op) const {
     if (IsString() && op.IsString())
         return Value(GetString() > op.GetString());
     
-    cerr << "Run-Time Error: Illegal operands for >" << endl;
+    *ValueErrors << "Run-Time Error: Illegal operands for >" << endl;
     return Value();
 }
 
@@ -130,7 +132,7 @@ Value Value::operator<(const Value& op) const {
     if (IsString() && op.IsString())
         return Value(GetString() < op.GetString());
     
-    cerr << "Run-Time Error: Illegal operands for <" << endl;
+    *ValueErrors << "Run-Time Error: Illegal operands for <" << endl;
     return Value();
 }
 
@@ -144,7 +146,7 @@ Value Value::operator<=(const Value& op) const {
     if (IsString() && op.IsString())
         return Value(GetString() <= op.GetString());
     
-    cerr << "Run-Time Error: Illegal operands for >" << endl;
+    *ValueErrors << "Run-Time Error: Illegal operands for >" << endl;
     return Value();}
 
 Value Value::operator>=(const Value& op) const {
@@ -157,7 +159,7 @@ Value Value::operator>=(const Value& op) const {
     if (IsString() && op.IsString())
         return Value(GetString() >= op.GetString());
     
-    cerr << "Run-Time Error: Illegal operands for >" << endl;
+    *ValueErrors << "Run-Time Error: Illegal operands for >" << endl;
     return Value();
 }
 
@@ -168,7 +170,7 @@ Value Value::operator&&(const Value& op) const {
     if (IsBool() && op.IsBool())
         return Value(GetBool() && op.GetBool());
     
-    cerr << "Run-Time Error: Illegal operands for &&" << endl;
+    *ValueErrors << "Run-Time Error: Illegal operands for &&" << endl;
     return Value();
 }
 
@@ -176,7 +178,7 @@ Value Value::operator||(const Value& op) const {
     if (IsBool() && op.IsBool())
         return Value(GetBool() || op.GetBool());
     
-    cerr << "Run-Time Error: Illegal operands for ||" << endl;
+    *ValueErrors << "Run-Time Error: Illegal operands for ||" << endl;
     return Value();
 }
 
@@ -184,7 +186,7 @@ Value Value::operator!(void) const {
     if (IsBool())
         return Value(!GetBool());
     
-    cerr << "Run-Time Error: Illegal operands for !" << endl;
+    *ValueErrors << "Run-Time Error: Illegal operands for !" << endl;
     return Value();
 }
 
@@ -212,7 +214,7 @@ Value Value::Concat(const Value& op) const {
         return result;
     }
 
-    cerr << "Run-Time Error: Illegal operands for Concat" << endl;
+    *ValueErrors << "Run-Time Error: Illegal operands for Concat" << endl;
     return Value();
 }
 
@@ -225,7 +227,7 @@ Value Value::Exp(const Value& op) const {
             return Value(0.0);
         }
         else if(GetReal() == 0.0 && op.GetReal() < 0) {
-            cerr << "Run-Time Error: Zero raised to negative power" << endl;
+            *ValueErrors << "Run-Time Error: Zero raised to negative power" << endl;
             return Value();
         }
         else if(op.GetReal() < 0) {
@@ -234,6 +236,6 @@ Value Value::Exp(const Value& op) const {
         }
         return Value(pow(GetReal(), op.GetReal()));
     }
-    cerr << "Run-Time Error: Illegal operands for Exp" << endl;
+    *ValueErrors << "Run-Time Error: Illegal operands for Exp" << endl;
     return Value();
 }
\ No newline at end of file
@@ -0,0 +1,474 @@
+/*
+ * vm.cpp
+ * Dispatch loop running the register bytecode of a SADAL procedure
+ * CS280 - Spring 2025
+ *
+ * Each instruction makes the checks of the tree node it came from, with the
+ * same messages, and the Value operators do the arithmetic, so a program
+ * prints the same whichever way it is run. Where the declarations fix the
+ * operand types, the compiler picks an instruction for those types instead,
+ * which works on the raw values with no checks of type.
+ *
+ * With GCC or Clang every instruction jumps straight to the code of the next
+ * one through a table of label addresses (computed goto), which gives each
+ * its own indirect branch to predict; elsewhere, or with VM_SWITCH defined,
+ * one switch at the top of a loop dispatches them all.
+ */
+
+#include "bytecode.h"
+#include "parserInterp.h"
+#include "runtime.h"
+
+#if (defined(__GNUC__) || defined(__clang__)) && !defined(VM_SWITCH)
+#define VM_THREADED 1
+#endif
+
+#ifdef VM_THREADED
+#define CASE(op)	L_##op
+#define NEXT()		do { if( STEP ) return 2 + int(pc - start); in = pc++; goto *labels[in->op]; } while( 0 )
+#else
+#define CASE(op)	case op
+#define NEXT()		break
+#endif
+
+const char* DispatchKind()
+{
+#ifdef VM_THREADED
+	return "computed goto";
+#else
+	return "switch";
+#endif
+}
+
+//report the chain of the instruction that failed after its own error
+static bool Fail(Runtime& rt, const Code& code, int at)
+{
+	const Site& site = code.sites[at];
+	for( int i = site.chain; i >= 0; i = code.chains[i].next )
+		RunError(rt, rt.errLine, code.chains[i].msg);
+	return false;
+}
+
+//run-time error of the instruction at, then its chain
+static bool Fail(Runtime& rt, const Code& code, int at, const string& msg)
+{
+	RunError(rt, code.sites[at].line, msg);
+	return Fail(rt, code, at);
+}
+
+//Runs code on the registers r from the instruction at pc: to the end, or with
+//STEP that instruction alone. 0 if the program failed, 1 if it halted, and
+//after a step 2 + the index of the instruction to run next.
+template <bool STEP>
+static int Exec(const Code& code, Runtime& rt, Value* r, const Instr* pc)
+{
+	const Instr* start = code.code.data();
+	const Instr* in;
+
+#ifdef VM_THREADED
+	//in OpCode order
+	static const void* const labels[] = {
+		&&L_OP_MOVE, &&L_OP_CHECK, &&L_OP_ISINT, &&L_OP_INDEX, &&L_OP_SLICE,
+		&&L_OP_SIGN, &&L_OP_NOT,
+		&&L_OP_ADD, &&L_OP_SUB, &&L_OP_CONCAT, &&L_OP_MUL, &&L_OP_DIV, &&L_OP_MOD,
+		&&L_OP_EXP,
+		&&L_OP_EQ, &&L_OP_NEQ, &&L_OP_LTHAN, &&L_OP_LTE, &&L_OP_GTHAN, &&L_OP_GTE,
+		&&L_OP_AND, &&L_OP_OR, &&L_OP_TESTBOOL,
+		&&L_OP_PRINT, &&L_OP_GET, &&L_OP_ASSIGN, &&L_OP_INIT, &&L_OP_REDEFINED,
+		&&L_OP_COND, &&L_OP_JUMP, &&L_OP_FAIL, &&L_OP_HALT,
+		&&L_OP_TAKE,
+		&&L_OP_ADDI, &&L_OP_SUBI, &&L_OP_MULI, &&L_OP_DIVI, &&L_OP_MODI,
+		&&L_OP_ADDR, &&L_OP_SUBR, &&L_OP_MULR, &&L_OP_DIVR,
+		&&L_OP_EQI, &&L_OP_NEQI, &&L_OP_LTHANI, &&L_OP_LTEI, &&L_OP_GTHANI, &&L_OP_GTEI,
+		&&L_OP_EQR, &&L_OP_NEQR, &&L_OP_LTHANR, &&L_OP_LTER, &&L_OP_GTHANR, &&L_OP_GTER,
+		&&L_OP_EQS, &&L_OP_NEQS, &&L_OP_CONCATS,
+		&&L_OP_NOTB, &&L_OP_ANDB, &&L_OP_ORB, &&L_OP_CONDB
+	};
+	static_assert(sizeof(labels) / sizeof(labels[0]) == OP_COUNT, "a label for every opcode");
+	in = pc++;
+	goto *labels[in->op];
+#else
+	for( ;; ) {
+	in = pc++;
+	switch( in->op ) {
+#endif
+
+	CASE(OP_MOVE):
+		r[in->a] = r[in->b];
+		NEXT();
+
+	CASE(OP_CHECK):
+		if( r[in->a].IsErr() )
+			return Fail(rt, code, in->site, "Uninitialized variable: " + string(code.names[in->a]));
+		NEXT();
+
+	CASE(OP_ISINT):
+		if( !r[in->a].IsInt() )
+			return Fail(rt, code, in->site, "Range indices must be integers");
+		NEXT();
+
+	CASE(OP_INDEX): {
+		Value str = r[in->b];
+		if( !Substring(rt, str, r[in->c].GetInt(), NULL, code.sites[in->site].line) )
+			return Fail(rt, code, in->site);
+		r[in->a] = move(str);
+		NEXT();
+	}
+
+	CASE(OP_SLICE):
+		if( !r[in->c].IsInt() )
+			return Fail(rt, code, in->site, "Range indices must be integers");
+		if( r[in->b].GetInt() > r[in->c].GetInt() )
+			return Fail(rt, code, in->site, "Invalid range - start index > end index");
+		if( !Substring(rt, r[in->a], r[in->b].GetInt(), &r[in->c], code.sites[in->site].line) )
+			return Fail(rt, code, in->site);
+		NEXT();
+
+	CASE(OP_SIGN):
+		//the sign itself was applied to a numeric constant by the parser
+		if( !r[in->a].IsInt() && !r[in->a].IsReal() )
+			return Fail(rt, code, in->site, "Run-Time Error-Illegal operand type for sign operation");
+		NEXT();
+
+	CASE(OP_NOT):
+		if( !r[in->b].IsBool() )
+			return Fail(rt, code, in->site, "Run-Time Error-Illegal operand type for NOT operation");
+		try {
+			r[in->a] = !r[in->b];
+		} catch (...) {
+			return Fail(rt, code, in->site, "Run-Time Error-Illegal NOT operation");
+		}
+		NEXT();
+
+	CASE(OP_ADD):
+		try {
+			r[in->a] = r[in->b] + r[in->c];
+		} catch (...) {
+			return Fail(rt, code, in->site, "Run-Time Error-Illegal operation");
+		}
+		NEXT();
+
+	CASE(OP_SUB):
+		try {
+			r[in->a] = r[in->b] - r[in->c];
+		} catch (...) {
+			return Fail(rt, code, in->site, "Run-Time Error-Illegal operation");
+		}
+		NEXT();
+
+	CASE(OP_CONCAT):
+		try {
+			r[in->a] = r[in->b].Concat(r[in->c]);
+		} catch (...) {
+			return Fail(rt, code, in->site, "Run-Time Error-Illegal operation");
+		}
+		NEXT();
+
+	CASE(OP_MUL):
+		try {
+			r[in->a] = r[in->b] * r[in->c];
+		} catch (...) {
+			return Fail(rt, code, in->site, "Run-Time Error-Illegal operation");
+		}
+		NEXT();
+
+	CASE(OP_DIV):
+		if( (r[in->c].IsInt() && r[in->c].GetInt() == 0) ||
+		    (r[in->c].IsReal() && r[in->c].GetReal() == 0.0) )
+			return Fail(rt, code, in->site, "Run-Time Error-Illegal division by zero");
+		try {
+			r[in->a] = r[in->b] / r[in->c];
+		} catch (...) {
+			return Fail(rt, code, in->site, "Run-Time Error-Illegal operation");
+		}
+		NEXT();
+
+	CASE(OP_MOD):
+		if( !r[in->b].IsInt() || !r[in->c].IsInt() )
+			return Fail(rt, code, in->site, "Run-Time Error-Illegal operand types for MOD");
+		if( r[in->c].GetInt() == 0 )
+			return Fail(rt, code, in->site, "Run-Time Error-Illegal mod by zero");
+		try {
+			r[in->a] = r[in->b] % r[in->c];
+		} catch (...) {
+			return Fail(rt, code, in->site, "Run-Time Error-Illegal operation");
+		}
+		NEXT();
+
+	CASE(OP_EXP):
+		if( !r[in->b].IsReal() || !r[in->c].IsReal() )
+			return Fail(rt, code, in->site, "Run-Time Error-Exponentiation requires float operands");
+		try {
+			r[in->a] = r[in->b].Exp(r[in->c]);
+		} catch (...) {
+			return Fail(rt, code, in->site, "Run-Time Error-Illegal exponentiation operation");
+		}
+		NEXT();
+
+	CASE(OP_EQ):
+		try {
+			r[in->a] = r[in->b] == r[in->c];
+		} catch (...) {
+			return Fail(rt, code, in->site, "Run-Time Error-Illegal operand types for comparison");
+		}
+		NEXT();
+
+	CASE(OP_NEQ):
+		try {
+			r[in->a] = r[in->b] != r[in->c];
+		} catch (...) {
+			return Fail(rt, code, in->site, "Run-Time Error-Illegal operand types for comparison");
+		}
+		NEXT();
+
+	CASE(OP_LTHAN):
+		try {
+			r[in->a] = r[in->b] < r[in->c];
+		} catch (...) {
+			return Fail(rt, code, in->site, "Run-Time Error-Illegal operand types for comparison");
+		}
+		NEXT();
+
+	CASE(OP_LTE):
+		try {
+			r[in->a] = r[in->b] <= r[in->c];
+		} catch (...) {
+			return Fail(rt, code, in->site, "Run-Time Error-Illegal operand types for comparison");
+		}
+		NEXT();
+
+	CASE(OP_GTHAN):
+		try {
+			r[in->a] = r[in->b] > r[in->c];
+		} catch (...) {
+			return Fail(rt, code, in->site, "Run-Time Error-Illegal operand types for comparison");
+		}
+		NEXT();
+
+	CASE(OP_GTE):
+		try {
+			r[in->a] = r[in->b] >= r[in->c];
+		} catch (...) {
+			return Fail(rt, code, in->site, "Run-Time Error-Illegal operand types for comparison");
+		}
+		NEXT();
+
+	CASE(OP_AND):
+	CASE(OP_OR):
+		if( !r[in->b].IsBool() )
+			return Fail(rt, code, in->site, "Run-Time Error-Left operand of logical operation must be boolean");
+		r[in->a] = r[in->b];
+		if( r[in->a].GetBool() == (in->op == OP_OR) )
+			pc = start + in->c;
+		NEXT();
+
+	CASE(OP_TESTBOOL):
+		//with the left operand deciding nothing, the right one is the result
+		if( !r[in->a].IsBool() )
+			return Fail(rt, code, in->site, "Run-Time Error-Right operand of logical operation must be boolean");
+		NEXT();
+
+	CASE(OP_PRINT):
+		if( in->b )
+			rt.out << r[in->a] << endl;
+		else
+			rt.out << r[in->a];
+		NEXT();
+
+	CASE(OP_GET):
+		if( !ReadInput(rt, code.sites[in->site].type, code.sites[in->site].line, r[in->a]) )
+			return Fail(rt, code, in->site);
+		NEXT();
+
+	CASE(OP_ASSIGN):
+		if( !OfType(code.sites[in->site].type, r[in->b]) )
+			return Fail(rt, code, in->site, "Type mismatch in assignment");
+		if( in->c )
+			r[in->a] = move(r[in->b]);
+		else
+			r[in->a] = r[in->b];
+		NEXT();
+
+	CASE(OP_INIT):
+		if( !OfType(code.sites[in->site].type, r[in->a]) )
+			return Fail(rt, code, in->site, "Type mismatch in initialization");
+		NEXT();
+
+	CASE(OP_REDEFINED):
+		return Fail(rt, code, in->site, "Variable redefinition: " + string(code.names[code.sites[in->site].sym]));
+
+	CASE(OP_COND):
+		if( !r[in->a].IsBool() )
+			return Fail(rt, code, in->site, code.sites[in->site].sym == 0
+				? "Run-Time Error-IF condition must be boolean"
+				: "Run-Time Error-ELSIF condition must be boolean");
+		if( !r[in->a].GetBool() )
+			pc = start + in->c;
+		NEXT();
+
+	CASE(OP_JUMP):
+		pc = start + in->c;
+		NEXT();
+
+	CASE(OP_FAIL):
+		for( const SyntaxMsg& e : code.failures[in->a] )
+			RunError(rt, e.line, e.msg);
+		return Fail(rt, code, in->site);
+
+	CASE(OP_HALT):
+		if( rt.errors == 0 )
+			rt.out << endl << "(DONE)" << endl;
+		return true;
+
+	CASE(OP_TAKE):
+		r[in->a] = move(r[in->b]);
+		NEXT();
+
+	CASE(OP_ADDI):
+		r[in->a].PutInt(r[in->b].RawInt() + r[in->c].RawInt());
+		NEXT();
+
+	CASE(OP_SUBI):
+		r[in->a].PutInt(r[in->b].RawInt() - r[in->c].RawInt());
+		NEXT();
+
+	CASE(OP_MULI):
+		r[in->a].PutInt(r[in->b].RawInt() * r[in->c].RawInt());
+		NEXT();
+
+	CASE(OP_DIVI):
+		if( r[in->c].RawInt() == 0 )
+			return Fail(rt, code, in->site, "Run-Time Error-Illegal division by zero");
+		r[in->a].PutInt(r[in->b].RawInt() / r[in->c].RawInt());
+		NEXT();
+
+	CASE(OP_MODI):
+		if( r[in->c].RawInt() == 0 )
+			return Fail(rt, code, in->site, "Run-Time Error-Illegal mod by zero");
+		r[in->a].PutInt(r[in->b].RawInt() % r[in->c].RawInt());
+		NEXT();
+
+	CASE(OP_ADDR):
+		r[in->a].PutReal(r[in->b].RawReal() + r[in->c].RawReal());
+		NEXT();
+
+	CASE(OP_SUBR):
+		r[in->a].PutReal(r[in->b].RawReal() - r[in->c].RawReal());
+		NEXT();
+
+	CASE(OP_MULR):
+		r[in->a].PutReal(r[in->b].RawReal() * r[in->c].RawReal());
+		NEXT();
+
+	CASE(OP_DIVR):
+		if( r[in->c].RawReal() == 0.0 )
+			return Fail(rt, code, in->site, "Run-Time Error-Illegal division by zero");
+		r[in->a].PutReal(r[in->b].RawReal() / r[in->c].RawReal());
+		NEXT();
+
+	CASE(OP_EQI):
+		r[in->a].PutBool(r[in->b].RawInt() == r[in->c].RawInt());
+		NEXT();
+
+	CASE(OP_NEQI):
+		r[in->a].PutBool(r[in->b].RawInt() != r[in->c].RawInt());
+		NEXT();
+
+	CASE(OP_LTHANI):
+		r[in->a].PutBool(r[in->b].RawInt() < r[in->c].RawInt());
+		NEXT();
+
+	CASE(OP_LTEI):
+		r[in->a].PutBool(r[in->b].RawInt() <= r[in->c].RawInt());
+		NEXT();
+
+	CASE(OP_GTHANI):
+		r[in->a].PutBool(r[in->b].RawInt() > r[in->c].RawInt());
+		NEXT();
+
+	CASE(OP_GTEI):
+		r[in->a].PutBool(r[in->b].RawInt() >= r[in->c].RawInt());
+		NEXT();
+
+	CASE(OP_EQR):
+		r[in->a].PutBool(r[in->b].RawReal() == r[in->c].RawReal());
+		NEXT();
+
+	CASE(OP_NEQR):
+		r[in->a].PutBool(r[in->b].RawReal() != r[in->c].RawReal());
+		NEXT();
+
+	CASE(OP_LTHANR):
+		r[in->a].PutBool(r[in->b].RawReal() < r[in->c].RawReal());
+		NEXT();
+
+	CASE(OP_LTER):
+		r[in->a].PutBool(r[in->b].RawReal() <= r[in->c].RawReal());
+		NEXT();
+
+	CASE(OP_GTHANR):
+		r[in->a].PutBool(r[in->b].RawReal() > r[in->c].RawReal());
+		NEXT();
+
+	CASE(OP_GTER):
+		r[in->a].PutBool(r[in->b].RawReal() >= r[in->c].RawReal());
+		NEXT();
+
+	CASE(OP_EQS):
+		r[in->a].PutBool(r[in->b].RawString() == r[in->c].RawString());
+		NEXT();
+
+	CASE(OP_NEQS):
+		r[in->a].PutBool(r[in->b].RawString() != r[in->c].RawString());
+		NEXT();
+
+	CASE(OP_CONCATS): {
+		Value cat(r[in->b].RawString() + r[in->c].RawString());
+		cat.SetstrLen(cat.RawString().length());
+		r[in->a] = move(cat);
+		NEXT();
+	}
+
+	CASE(OP_NOTB):
+		r[in->a].PutBool(!r[in->b].RawBool());
+		NEXT();
+
+	CASE(OP_ANDB):
+	CASE(OP_ORB):
+		r[in->a].PutBool(r[in->b].RawBool());
+		if( r[in->a].RawBool() == (in->op == OP_ORB) )
+			pc = start + in->c;
+		NEXT();
+
+	CASE(OP_CONDB):
+		if( !r[in->a].RawBool() )
+			pc = start + in->c;
+		NEXT();
+
+#ifndef VM_THREADED
+	default:
+		return 0;
+	}
+	if( STEP )
+		return 2 + int(pc - start);
+	}
+#endif
+}
+
+bool Run(const Code& code, Runtime& rt)
+{
+	vector<Value> regs(code.Registers());
+	copy(code.consts.begin(), code.consts.end(), regs.begin() + code.ConstBase());
+	return Exec<false>(code, rt, regs.data(), code.code.data()) == 1;
+}
+
+int Step(const Code& code, Runtime& rt, Value* regs, int at)
+{
+	return Exec<true>(code, rt, regs, code.code.data() + at);
+}
+
+bool Run(const Code& code)
+{
+	Runtime rt(cin, cout, cerr);
+	return Run(code, rt);
+}